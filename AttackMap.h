@@ -0,0 +1,110 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "MagicBitboards.h"
+#include "Position.h"
+
+namespace magicbb {
+
+// Attack map kept up to date move by move: the attack set of the piece on every
+// square and, per square, the set of pieces attacking it. A move only changes
+// the occupancy of a few squares (from, to, the en passant victim, the castling
+// rook), and a slider's attack set can only change if it attacks one of those
+// squares, so Update recomputes the moved pieces and just those sliders.
+// Like Position it is copy-make: keep the parent's map to undo a move.
+//
+//   AttackMap map;
+//   map.Compute(pos);
+//   Position next = pos.Play(move);
+//   AttackMap nextMap = map;
+//   nextMap.Update(pos, move, next);
+
+class AttackMap {
+public:
+    // Full recomputation from scratch
+    void Compute(const Position &pos) {
+        attacksFrom_.fill(0);
+        attackersTo_.fill(0);
+        for (Bitboard b = pos.occupied; b; b &= b - 1) {
+            int sq = LowestBit(b);
+            attacksFrom_[sq] = PieceAttacks(pos, sq);
+            for (Bitboard a = attacksFrom_[sq]; a; a &= a - 1)
+                attackersTo_[LowestBit(a)] |= BIT<Bitboard>(sq);
+        }
+    }
+
+    // Bring the map from `before` to `after = before.Play(move)`. Returns the
+    // number of pieces whose attacks were recomputed.
+    int Update(const Position &before, Move move, const Position &after) {
+        int from = MoveFrom(move), to = MoveTo(move);
+        Bitboard touched = BIT<Bitboard>(from) | BIT<Bitboard>(to);
+        if (MoveKindOf(move) == EnPassantMove) {
+            touched |= BIT<Bitboard>(to + (before.sideToMove == White ? -8 : 8));
+        } else if (MoveKindOf(move) == CastlingMove) {
+            touched |= BIT<Bitboard>(to > from ? to + 1 : to - 2) | BIT<Bitboard>(to > from ? to - 1 : to + 1);
+        }
+
+        // Sliders that saw any touched square before the move; the rest keep their rays
+        Bitboard sliders = after.pieces[White][Rook] | after.pieces[Black][Rook] |
+                           after.pieces[White][Bishop] | after.pieces[Black][Bishop] |
+                           after.pieces[White][Queen] | after.pieces[Black][Queen];
+        Bitboard stale = 0;
+        for (Bitboard b = touched; b; b &= b - 1)
+            stale |= attackersTo_[LowestBit(b)];
+        stale = (stale & sliders & ~touched) | touched;
+
+        int recomputed = 0;
+        for (Bitboard b = stale; b; b &= b - 1) {
+            int sq = LowestBit(b);
+            Bitboard attacks = after.board[sq] == Position::NoPiece ? 0 : PieceAttacks(after, sq);
+            Bitboard bit = BIT<Bitboard>(sq);
+            for (Bitboard gone = attacksFrom_[sq] & ~attacks; gone; gone &= gone - 1)
+                attackersTo_[LowestBit(gone)] &= ~bit;
+            for (Bitboard added = attacks & ~attacksFrom_[sq]; added; added &= added - 1)
+                attackersTo_[LowestBit(added)] |= bit;
+            attacksFrom_[sq] = attacks;
+            recomputed++;
+        }
+        return recomputed;
+    }
+
+    // Squares attacked by the piece on sq (0 if the square is empty)
+    Bitboard AttacksFrom(int sq) const { return attacksFrom_[sq]; }
+
+    // Pieces of either color attacking sq
+    Bitboard AttackersTo(int sq) const { return attackersTo_[sq]; }
+
+    // Every square attacked by `color`
+    Bitboard Attacks(const Position &pos, Color color) const {
+        Bitboard attacks = 0;
+        for (Bitboard b = pos.colors[color]; b; b &= b - 1)
+            attacks |= attacksFrom_[LowestBit(b)];
+        return attacks;
+    }
+
+    bool operator==(const AttackMap &other) const {
+        return attacksFrom_ == other.attacksFrom_ && attackersTo_ == other.attackersTo_;
+    }
+
+    // Attacks of the piece on an occupied square
+    static Bitboard PieceAttacks(const Position &pos, int sq) {
+        Color color = Color(pos.board[sq] / 6);
+        switch (PieceType(pos.board[sq] % 6)) {
+            case Pawn: return PawnAttacks[color][sq];
+            case Knight: return KnightAttacks[sq];
+            case Bishop: return GetBishopAttacks(sq, pos.occupied);
+            case Rook: return GetRookAttacks(sq, pos.occupied);
+            case Queen: return GetQueenAttacks(sq, pos.occupied);
+            case King: return KingAttacks[sq];
+        }
+        return 0;
+    }
+
+private:
+    std::array<Bitboard, 64> attacksFrom_{};
+    std::array<Bitboard, 64> attackersTo_{};
+};
+
+}  // namespace magicbb
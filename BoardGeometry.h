@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Board geometry and word-size generic helpers, so the same mask generation,
+// blocker enumeration, search and lookup code serves 8x8 chess on uint64_t and
+// larger variant boards (10x8, 10x10) on unsigned __int128.
+// Squares are numbered rank-major: sq = rank * Files + file.
+
+template<int FileCount, int RankCount, class WordType> struct BoardGeometry {
+    using Word = WordType;
+    static constexpr int Files = FileCount;
+    static constexpr int Ranks = RankCount;
+    static constexpr int Squares = FileCount * RankCount;
+    static_assert(Squares <= int(sizeof(Word) * 8), "board does not fit in the word type");
+
+    static constexpr int File(int sq) { return sq % Files; }
+    static constexpr int Rank(int sq) { return sq / Files; }
+    static constexpr int Square(int rank, int file) { return rank * Files + file; }
+};
+
+using uint128 = unsigned __int128;
+
+using Chess8x8 = BoardGeometry<8, 8, uint64_t>;
+using Board10x8 = BoardGeometry<10, 8, uint128>;
+using Board10x10 = BoardGeometry<10, 10, uint128>;
+
+// High 64 bits of the magic product; the index is always hash >> (64 - indexBits).
+// On 64-bit boards this is the usual blockers * magic.
+constexpr uint64_t MagicHash(uint64_t blockers, uint64_t magic) {
+    return blockers * magic;
+}
+
+// On 128-bit boards the two halves are multiplied by the magic and by the magic
+// rotated by 32 bits and summed: two plain 64x64 multiplies and an add, instead
+// of a full 128x128 product. Rotating keeps bits k and k + 64 of the board from
+// landing on the same product bits, while the magic itself stays 64 bits.
+constexpr uint64_t MagicHash(uint128 blockers, uint64_t magic) {
+    uint64_t low = uint64_t(blockers), high = uint64_t(blockers >> 64);
+    return low * magic + high * ((magic << 32) | (magic >> 32));
+}
+
+template<class G> constexpr typename G::Word SquareBit(int sq) {
+    return typename G::Word(1) << sq;
+}
+
+template<class G> constexpr int PopCount(typename G::Word word) {
+    int count = 0;
+    for (; word; word &= word - 1)
+        count++;
+    return count;
+}
+
+// Rook relevant-occupancy mask (excluding the board edges)
+template<class G> constexpr typename G::Word GenerateRookMask(int sq) {
+    typename G::Word output = 0;
+    int rank = G::Rank(sq), file = G::File(sq);
+    for (int r = rank + 1; r < G::Ranks - 1; r++) output |= SquareBit<G>(G::Square(r, file));
+    for (int r = rank - 1; r > 0; r--) output |= SquareBit<G>(G::Square(r, file));
+    for (int f = file + 1; f < G::Files - 1; f++) output |= SquareBit<G>(G::Square(rank, f));
+    for (int f = file - 1; f > 0; f--) output |= SquareBit<G>(G::Square(rank, f));
+    return output;
+}
+
+// Bishop relevant-occupancy mask (excluding the board edges)
+template<class G> constexpr typename G::Word GenerateBishopMask(int sq) {
+    typename G::Word output = 0;
+    int rank = G::Rank(sq), file = G::File(sq);
+    for (int r = rank + 1, f = file + 1; r < G::Ranks - 1 && f < G::Files - 1; r++, f++)
+        output |= SquareBit<G>(G::Square(r, f));
+    for (int r = rank + 1, f = file - 1; r < G::Ranks - 1 && f > 0; r++, f--)
+        output |= SquareBit<G>(G::Square(r, f));
+    for (int r = rank - 1, f = file + 1; r > 0 && f < G::Files - 1; r--, f++)
+        output |= SquareBit<G>(G::Square(r, f));
+    for (int r = rank - 1, f = file - 1; r > 0 && f > 0; r--, f--)
+        output |= SquareBit<G>(G::Square(r, f));
+    return output;
+}
+
+// Slide from sq in direction (dr, df) until the edge or the first blocker (inclusive)
+template<class G> constexpr typename G::Word SlideRay(int sq, int dr, int df, typename G::Word blockers) {
+    typename G::Word attacks = 0;
+    for (int r = G::Rank(sq) + dr, f = G::File(sq) + df;
+         r >= 0 && r < G::Ranks && f >= 0 && f < G::Files; r += dr, f += df) {
+        typename G::Word bit = SquareBit<G>(G::Square(r, f));
+        attacks |= bit;
+        if (blockers & bit) break;
+    }
+    return attacks;
+}
+
+template<class G> constexpr typename G::Word GenerateRookAttacksOn(int sq, typename G::Word blockers) {
+    return SlideRay<G>(sq, 1, 0, blockers) | SlideRay<G>(sq, -1, 0, blockers) |
+           SlideRay<G>(sq, 0, 1, blockers) | SlideRay<G>(sq, 0, -1, blockers);
+}
+
+template<class G> constexpr typename G::Word GenerateBishopAttacksOn(int sq, typename G::Word blockers) {
+    return SlideRay<G>(sq, 1, 1, blockers) | SlideRay<G>(sq, 1, -1, blockers) |
+           SlideRay<G>(sq, -1, 1, blockers) | SlideRay<G>(sq, -1, -1, blockers);
+}
+
+// Every subset of mask, in carry-rippler order starting from the empty set
+template<class G> void FillBlockerSubsets(typename G::Word mask, std::vector<typename G::Word> &array) {
+    array.clear();
+    array.reserve(size_t(1) << PopCount<G>(mask));
+    typename G::Word blockers = 0;
+    do {
+        array.push_back(blockers);
+        blockers = (blockers - mask) & mask;
+    } while (blockers != 0);
+}
+
+// Magic lookup tables for any geometry: one mask, magic and shift per square
+template<class G> struct VariantMagicTable {
+    using Word = typename G::Word;
+
+    struct Entry {
+        Word mask;
+        uint64_t magic;
+        int shift;
+        std::vector<Word> attacks;
+    };
+    std::vector<Entry> squares;
+
+    // entries[sq] needs .magic and .shift, as in the searcher's array output for this geometry
+    template<class MagicEntryType> void Build(bool isBishop, const MagicEntryType *entries) {
+        squares.assign(G::Squares, Entry());
+        std::vector<Word> subsets;
+        for (int sq = 0; sq < G::Squares; sq++) {
+            Entry &entry = squares[sq];
+            entry.mask = isBishop ? GenerateBishopMask<G>(sq) : GenerateRookMask<G>(sq);
+            entry.magic = entries[sq].magic;
+            entry.shift = entries[sq].shift;
+            entry.attacks.assign(size_t(1) << (64 - entry.shift), 0);
+            FillBlockerSubsets<G>(entry.mask, subsets);
+            for (Word b : subsets)
+                entry.attacks[MagicHash(b, entry.magic) >> entry.shift] =
+                    isBishop ? GenerateBishopAttacksOn<G>(sq, b) : GenerateRookAttacksOn<G>(sq, b);
+        }
+    }
+
+    Word Lookup(int sq, Word occupancy) const {
+        const Entry &entry = squares[sq];
+        return entry.attacks[MagicHash(occupancy & entry.mask, entry.magic) >> entry.shift];
+    }
+};
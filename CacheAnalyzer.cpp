@@ -0,0 +1,387 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <cstdint>
+#include <random>
+#include <algorithm>
+#include <iomanip>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "MagicBitboards.h"
+#include "OccupancyCorpus.h"
+#include "Position.h"
+
+using namespace std;
+using namespace magicbb;
+
+// Cache footprint of a magic set: table bytes per square and in total, and a
+// replay of slider lookups from played-out games through a small set-associative
+// L1/L2 model, for each table layout the library offers.
+
+struct MagicSet {
+    MagicEntry rook[64];
+    MagicEntry bishop[64];
+};
+
+// Read the searcher's "Array format" output (or the README arrays): entries
+// "{0x..., shift, tableSize}" following a declaration that names rook or bishop.
+// Squares the file does not cover keep the library's magics; unsolved entries
+// (shift 0 or 64) do too, and are reported.
+bool LoadMagicSet(const string &path, MagicSet &set) {
+    ifstream file(path);
+    if (!file) return false;
+    MagicEntry *current = nullptr;
+    bool currentIsBishop = false;
+    int count = 0, loaded = 0;
+    vector<string> substituted;
+    string line;
+    while (getline(file, line)) {
+        string lower = line;
+        transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+        if (lower.find('[') != string::npos && lower.find('=') != string::npos) {
+            currentIsBishop = lower.find("bishop") != string::npos;
+            if (currentIsBishop) current = set.bishop;
+            else if (lower.find("rook") != string::npos) current = set.rook;
+            else current = nullptr;
+            count = 0;
+        }
+        size_t brace = line.find("{0x");
+        if (!current || brace == string::npos || count >= 64) continue;
+        MagicEntry entry;
+        char comma;
+        istringstream fields(line.substr(brace + 1));
+        if (!(fields >> hex >> entry.magic >> comma >> dec >> entry.shift >> comma >> entry.tableSize)) continue;
+        if (entry.shift > 0 && entry.shift < 64) current[count] = entry;
+        else substituted.push_back((currentIsBishop ? "b" : "r") + SquareName(count));
+        count++;
+        loaded++;
+    }
+    // Unsolved squares in the searcher's output (shift 64) are modelled with the library magic
+    if (!substituted.empty()) {
+        cerr << "No magic in " << path << " for";
+        for (const string &square : substituted) cerr << " " << square;
+        cerr << "; using the library magics there\n";
+    }
+    return loaded > 0;
+}
+
+// One square's table under a magic set: slot -> attack set, plus the compact dictionary
+struct SquareLayout {
+    int size = 0;
+    int distinct = 0;
+    vector<uint16_t> dictionaryEntry;  // slot -> index of its attack set in the dictionary
+    bool valid = true;
+};
+
+SquareLayout BuildSquareLayout(int sq, const MagicEntry &magic, bool isBishop) {
+    SquareLayout layout;
+    layout.size = magic.tableSize;
+    vector<Bitboard> table(magic.tableSize, 0);
+    Bitboard mask = isBishop ? BishopMasks[sq] : RookMasks[sq];
+    Bitboard blockers = 0;
+    do {
+        size_t index = (blockers * magic.magic) >> magic.shift;
+        Bitboard attack = isBishop ? GenerateBishopAttacks(sq, blockers) : GenerateRookAttacks(sq, blockers);
+        if (index >= table.size() || (table[index] && table[index] != attack)) layout.valid = false;
+        else table[index] = attack;
+        blockers = (blockers - mask) & mask;
+    } while (blockers != 0);
+
+    // Same dictionary order as CompactAttackTable::Build: first appearance by slot, empty slots share entry 0
+    unordered_map<Bitboard, int> known;
+    layout.dictionaryEntry.resize(table.size());
+    for (size_t slot = 0; slot < table.size(); slot++) {
+        auto it = known.find(table[slot]);
+        int entry = 0;
+        if (it != known.end()) entry = it->second;
+        else if (table[slot] != 0 || known.empty()) entry = known[table[slot]] = int(known.size());
+        layout.dictionaryEntry[slot] = uint16_t(entry);
+    }
+    layout.distinct = int(known.size());
+    return layout;
+}
+
+// Set-associative cache with true LRU replacement
+class CacheModel {
+public:
+    CacheModel(size_t bytes, int ways, int lineSize = 64)
+        : ways_(ways), lineShift_(__builtin_ctz(lineSize)),
+          sets_(max<size_t>(1, bytes / lineSize / ways)),
+          tags_(sets_ * ways, ~0ULL), stamps_(sets_ * ways, 0) {}
+
+    // Returns true on a hit; on a miss the line is filled, evicting the least recently used
+    bool Access(uint64_t address) {
+        uint64_t line = address >> lineShift_;
+        size_t set = line % sets_;
+        uint64_t *tags = &tags_[set * ways_];
+        uint64_t *stamps = &stamps_[set * ways_];
+        clock_++;
+        int victim = 0;
+        for (int way = 0; way < ways_; way++) {
+            if (tags[way] == line) {
+                stamps[way] = clock_;
+                return true;
+            }
+            if (stamps[way] < stamps[victim]) victim = way;
+        }
+        tags[victim] = line;
+        stamps[victim] = clock_;
+        return false;
+    }
+
+private:
+    int ways_;
+    int lineShift_;
+    size_t sets_;
+    vector<uint64_t> tags_;
+    vector<uint64_t> stamps_;
+    uint64_t clock_ = 0;
+};
+
+enum GamePhase { Opening, Middlegame, Endgame, PhaseCount };
+const char *PhaseNames[PhaseCount] = {"opening", "middlegame", "endgame"};
+
+GamePhase PhaseOf(Bitboard occupancy) {
+    int pieces = CountBits(occupancy);
+    return pieces >= 26 ? Opening : pieces >= 14 ? Middlegame : Endgame;
+}
+
+struct Query {
+    bool isBishop;
+    int sq;
+    Bitboard occupancy;
+};
+
+// Slider lookups of every position reached in random legal playouts from the start
+// position, in game order so consecutive queries share the locality a search would see
+void CollectQueries(int games, uint64_t seed, vector<Query> (&queries)[PhaseCount]) {
+    mt19937_64 rng(seed);
+    for (int game = 0; game < games; game++) {
+        Position pos;
+        pos.SetFen(StartFen);
+        for (int ply = 0; ply < 300 && pos.halfmoveClock < 100; ply++) {
+            vector<Query> &phase = queries[PhaseOf(pos.occupied)];
+            for (int color = White; color <= Black; color++) {
+                Bitboard bishops = pos.pieces[color][Bishop] | pos.pieces[color][Queen];
+                Bitboard rooks = pos.pieces[color][Rook] | pos.pieces[color][Queen];
+                for (; bishops; bishops &= bishops - 1) phase.push_back({true, LowestBit(bishops), pos.occupied});
+                for (; rooks; rooks &= rooks - 1) phase.push_back({false, LowestBit(rooks), pos.occupied});
+            }
+            MoveList moves;
+            GenerateLegalMoves(pos, moves);
+            if (moves.size() == 0) break;
+            pos = pos.Play(moves[rng() % moves.size()]);
+        }
+    }
+}
+
+// Slider lookups of every position in an EPD/FEN corpus, in file order
+void CollectCorpusQueries(const OccupancyCorpus &corpus, vector<Query> (&queries)[PhaseCount]) {
+    corpus.ForEachQuery([&](Piece piece, int sq, Bitboard occupancy) {
+        queries[PhaseOf(occupancy)].push_back({piece == Piece::Bishop, sq, occupancy});
+    });
+}
+
+// Byte offsets of every table touched by one lookup, for each layout
+enum LayoutKind { FlatLayout, Compact8Layout, Compact16Layout, LayoutCount };
+const char *LayoutNames[LayoutCount] = {"flat", "compact u8", "compact u16"};
+
+struct LayoutAddresses {
+    // Per square (rook 0..63, bishop 64..127): start of its slots and of its dictionary
+    size_t slotOffset[128];
+    size_t dictionaryOffset[128];
+    size_t bytes[LayoutCount];
+};
+
+// Lay the tables out as the library does: rook squares then bishop squares, each
+// layout in its own region; index and dictionary arrays are separate regions
+LayoutAddresses PlanLayouts(const vector<SquareLayout> &squares) {
+    LayoutAddresses plan;
+    size_t slots = 0, dictionary = 0;
+    for (int i = 0; i < 128; i++) {
+        plan.slotOffset[i] = slots;
+        plan.dictionaryOffset[i] = dictionary;
+        slots += squares[i].size;
+        dictionary += squares[i].distinct;
+    }
+    plan.bytes[FlatLayout] = slots * sizeof(Bitboard);
+    plan.bytes[Compact8Layout] = slots * sizeof(uint8_t) + dictionary * sizeof(Bitboard);
+    plan.bytes[Compact16Layout] = slots * sizeof(uint16_t) + dictionary * sizeof(Bitboard);
+    return plan;
+}
+
+struct CacheConfig {
+    size_t l1Bytes = 32 << 10;
+    int l1Ways = 8;
+    size_t l2Bytes = 1 << 20;
+    int l2Ways = 16;
+};
+
+struct ReplayResult {
+    uint64_t accesses = 0, l1Misses = 0, l2Misses = 0;
+    size_t linesTouched = 0;
+};
+
+ReplayResult Replay(const vector<Query> &queries, LayoutKind layout, const MagicSet &set,
+                    const vector<SquareLayout> &squares, const LayoutAddresses &plan, const CacheConfig &config) {
+    CacheModel l1(config.l1Bytes, config.l1Ways), l2(config.l2Bytes, config.l2Ways);
+    unordered_set<uint64_t> lines;
+    ReplayResult result;
+    const size_t indexWidth = layout == Compact8Layout ? 1 : layout == Compact16Layout ? 2 : 8;
+    // Dictionaries sit after the index arrays, on a fresh page
+    const uint64_t dictionaryBase = (plan.bytes[FlatLayout] / 8 * indexWidth + 4095) & ~uint64_t(4095);
+
+    auto touch = [&](uint64_t address) {
+        result.accesses++;
+        lines.insert(address >> 6);
+        if (l1.Access(address)) return;
+        result.l1Misses++;
+        if (!l2.Access(address)) result.l2Misses++;
+    };
+
+    for (const Query &query : queries) {
+        int item = (query.isBishop ? 64 : 0) + query.sq;
+        const MagicEntry &magic = query.isBishop ? set.bishop[query.sq] : set.rook[query.sq];
+        Bitboard mask = query.isBishop ? BishopMasks[query.sq] : RookMasks[query.sq];
+        size_t index = ((query.occupancy & mask) * magic.magic) >> magic.shift;
+        touch((plan.slotOffset[item] + index) * indexWidth);
+        if (layout != FlatLayout)
+            touch(dictionaryBase + (plan.dictionaryOffset[item] + squares[item].dictionaryEntry[index]) * sizeof(Bitboard));
+    }
+    result.linesTouched = lines.size();
+    return result;
+}
+
+void PrintSquareFootprints(const vector<SquareLayout> &squares) {
+    cout << "\nBytes per square (flat / compact u8 / compact u16):\n";
+    for (int isBishop = 0; isBishop < 2; isBishop++) {
+        cout << (isBishop ? "Bishop" : "Rook") << "\n";
+        for (int sq = 0; sq < 64; sq++) {
+            const SquareLayout &s = squares[isBishop * 64 + sq];
+            cout << "  " << SquareName(sq) << ": " << setw(6) << s.size * 8 << " " << setw(6) << s.size + s.distinct * 8
+                 << " " << setw(6) << s.size * 2 + s.distinct * 8 << "  (" << s.distinct << " distinct attack sets)\n";
+        }
+    }
+}
+
+void PrintUsage(const char *program) {
+    cout << "Usage: " << program << " [--magics FILE] [--corpus FILE | --games N] [--seed S] [--per-square]\n"
+         << "       [--l1 KB] [--l1-ways N] [--l2 KB] [--l2-ways N]\n"
+         << "  --magics FILE   magic set in the searcher's array format (default: the library's)\n"
+         << "  --corpus FILE   take the lookup stream from the positions of an EPD/FEN file\n"
+         << "  --games N       otherwise, random games played out for the stream (default 2000)\n"
+         << "  --per-square    print table bytes for every square\n"
+         << "  --l1, --l2      cache sizes in KB (default 32 and 1024, 8 and 16 ways)\n";
+}
+
+int main(int argc, char** argv) {
+    MagicSet set;
+    copy(begin(RookMagics), end(RookMagics), set.rook);
+    copy(begin(BishopMagics), end(BishopMagics), set.bishop);
+    CacheConfig config;
+    int games = 2000;
+    uint64_t seed = 1;
+    bool perSquare = false;
+    string corpusPath;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--magics" && i + 1 < argc) {
+            if (!LoadMagicSet(argv[++i], set)) {
+                cerr << "No magics found in " << argv[i] << "\n";
+                return 1;
+            }
+        } else if (arg == "--corpus" && i + 1 < argc) {
+            corpusPath = argv[++i];
+        } else if (arg == "--games" && i + 1 < argc) {
+            games = atoi(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--per-square") {
+            perSquare = true;
+        } else if (arg == "--l1" && i + 1 < argc) {
+            int kilobytes = atoi(argv[++i]);
+            if (kilobytes <= 0) {
+                cerr << "--l1 expects a positive size in KB\n";
+                return 1;
+            }
+            config.l1Bytes = size_t(kilobytes) << 10;
+        } else if (arg == "--l1-ways" && i + 1 < argc) {
+            config.l1Ways = atoi(argv[++i]);
+            if (config.l1Ways <= 0) {
+                cerr << "--l1-ways expects a positive number\n";
+                return 1;
+            }
+        } else if (arg == "--l2" && i + 1 < argc) {
+            int kilobytes = atoi(argv[++i]);
+            if (kilobytes <= 0) {
+                cerr << "--l2 expects a positive size in KB\n";
+                return 1;
+            }
+            config.l2Bytes = size_t(kilobytes) << 10;
+        } else if (arg == "--l2-ways" && i + 1 < argc) {
+            config.l2Ways = atoi(argv[++i]);
+            if (config.l2Ways <= 0) {
+                cerr << "--l2-ways expects a positive number\n";
+                return 1;
+            }
+        } else {
+            PrintUsage(argv[0]);
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    // Position.h's move generator needs the library's own tables
+    InitializeAttackTables();
+
+    vector<SquareLayout> squares;
+    bool allValid = true;
+    for (int isBishop = 0; isBishop < 2; isBishop++)
+        for (int sq = 0; sq < 64; sq++) {
+            squares.push_back(BuildSquareLayout(sq, isBishop ? set.bishop[sq] : set.rook[sq], isBishop));
+            if (!squares.back().valid) {
+                cerr << (isBishop ? "Bishop" : "Rook") << " magic for " << SquareName(sq) << " has collisions\n";
+                allValid = false;
+            }
+        }
+    if (!allValid) return 1;
+
+    LayoutAddresses plan = PlanLayouts(squares);
+    cout << "Table bytes:";
+    for (int layout = 0; layout < LayoutCount; layout++)
+        cout << "  " << LayoutNames[layout] << " " << plan.bytes[layout];
+    cout << "\n";
+    if (perSquare) PrintSquareFootprints(squares);
+
+    vector<Query> queries[PhaseCount];
+    if (corpusPath.empty()) {
+        CollectQueries(games, seed, queries);
+    } else {
+        OccupancyCorpus corpus;
+        if (!corpus.Open(corpusPath)) {
+            cerr << "Cannot open corpus " << corpusPath << "\n";
+            return 1;
+        }
+        CollectCorpusQueries(corpus, queries);
+    }
+
+    cout << "\nCache model: L1 " << (config.l1Bytes >> 10) << " KB " << config.l1Ways << "-way, L2 "
+         << (config.l2Bytes >> 10) << " KB " << config.l2Ways << "-way, 64-byte lines, LRU, lookups only\n";
+    cout << left << setw(12) << "phase" << setw(13) << "layout" << right << setw(10) << "lookups"
+         << setw(12) << "lines" << setw(14) << "working set" << setw(10) << "L1 miss" << setw(10) << "L2 miss" << "\n";
+    for (int phase = 0; phase < PhaseCount; phase++) {
+        for (int layout = 0; layout < LayoutCount; layout++) {
+            ReplayResult r = Replay(queries[phase], LayoutKind(layout), set, squares, plan, config);
+            double accesses = max<uint64_t>(1, r.accesses);
+            cout << left << setw(12) << PhaseNames[phase] << setw(13) << LayoutNames[layout] << right
+                 << setw(10) << queries[phase].size() << setw(12) << r.linesTouched
+                 << setw(11) << r.linesTouched * 64 / 1024 << " KB"
+                 << fixed << setprecision(2) << setw(9) << 100.0 * r.l1Misses / accesses << "%"
+                 << setw(9) << 100.0 * r.l2Misses / accesses << "%\n";
+        }
+    }
+    return 0;
+}
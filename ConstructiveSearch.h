@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Deterministic constructive magic search for 64-bit boards.
+//
+// Magic bits are decided from bit 63 down to bit 0, with at most maxSetBits
+// bits set. With bits above j fixed (partial magic M) and bits 0..j still open,
+// blocker b hashes to b*M + b*r for some r in [0, maxRest], so its index is
+// already known whenever that whole interval falls into one slot. Two blockers
+// with different attack sets whose indices are both known and equal make every
+// completion of the partial magic fail, so the subtree is cut.
+//
+// The tree is finite (every magic with <= maxSetBits bits), so exploring it to
+// the end without a hit proves that no such magic exists at this shift.
+// Subtrees are independent: callers split the search by fixing the top bits
+// (a prefix) and run one prefix per thread.
+
+class ConstructiveMagicSearch {
+public:
+    enum Status { Found, Exhausted, BudgetExceeded, Stopped };
+
+    // blockers[i] / references[i]: every blocker subset of the square and its attack set
+    ConstructiveMagicSearch(const uint64_t *blockers, const uint64_t *references, size_t count,
+                            int indexBits, int maxSetBits)
+        : blockers_(blockers), references_(references), count_(count),
+          shift_(64 - indexBits), maxSetBits_(maxSetBits),
+          products_(count, 0), slotStamp_(size_t(1) << indexBits, 0), slotValue_(size_t(1) << indexBits, 0) {}
+
+    // Search the subtree whose top prefixBits magic bits equal the top bits of prefix.
+    // nodeBudget is shared between all searches of one square; stop lets another
+    // thread cancel once a magic was found elsewhere.
+    Status SearchPrefix(uint64_t prefix, int prefixBits, std::atomic<int64_t> &nodeBudget,
+                        const std::atomic<bool> &stop) {
+        budget_ = &nodeBudget;
+        stop_ = &stop;
+        int used = 0;
+        for (size_t i = 0; i < count_; i++)
+            products_[i] = blockers_[i] * prefix;
+        for (int bit = 63; bit >= 64 - prefixBits; bit--)
+            used += (prefix >> bit) & 1;
+        if (used > maxSetBits_) return Exhausted;
+
+        magic_ = prefix;
+        return Descend(63 - prefixBits, maxSetBits_ - used);
+    }
+
+    uint64_t Magic() const { return magic_; }
+    int64_t Nodes() const { return nodes_; }
+
+private:
+    // Largest value the undecided bits 0..bit can still add with `remaining` more set bits
+    static uint64_t MaxRest(int bit, int remaining) {
+        if (bit < 0 || remaining <= 0) return 0;
+        int open = bit + 1;
+        uint64_t all = open == 64 ? ~0ULL : (1ULL << open) - 1;
+        if (remaining >= open) return all;
+        return all & ~((1ULL << (open - remaining)) - 1);
+    }
+
+    // True if some pair of blockers is already forced into the same slot with different attacks
+    bool ForcedCollision(int bit, int remaining) {
+        uint64_t rest = MaxRest(bit, remaining);
+        if (++stamp_ == 0) {
+            std::fill(slotStamp_.begin(), slotStamp_.end(), 0);
+            stamp_ = 1;
+        }
+        for (size_t i = 0; i < count_; i++) {
+            unsigned __int128 span = (unsigned __int128)blockers_[i] * rest;
+            unsigned __int128 high = (unsigned __int128)products_[i] + span;
+            if (high >> 64) continue;  // may still wrap: index unknown
+            uint64_t low = products_[i];
+            if ((low >> shift_) != (uint64_t(high) >> shift_)) continue;
+
+            size_t slot = low >> shift_;
+            if (slotStamp_[slot] != stamp_) {
+                slotStamp_[slot] = stamp_;
+                slotValue_[slot] = references_[i];
+            } else if (slotValue_[slot] != references_[i]) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Decide bit `bit` and below, with `remaining` set bits left
+    Status Descend(int bit, int remaining) {
+        if (stop_->load(std::memory_order_relaxed)) return Stopped;
+        if (budget_->fetch_sub(1, std::memory_order_relaxed) <= 0) return BudgetExceeded;
+        nodes_++;
+
+        if (ForcedCollision(bit, remaining)) return Exhausted;
+        // Nothing left to decide: with no collision every blocker was placed
+        if (bit < 0 || remaining == 0) return Found;
+
+        // Set bits first: magics need enough high bits to spread the index
+        bool budgetHit = false;
+        for (size_t i = 0; i < count_; i++)
+            products_[i] += blockers_[i] << bit;
+        magic_ |= 1ULL << bit;
+        Status status = Descend(bit - 1, remaining - 1);
+        if (status == Found || status == Stopped) return status;
+        budgetHit = status == BudgetExceeded;
+        for (size_t i = 0; i < count_; i++)
+            products_[i] -= blockers_[i] << bit;
+        magic_ &= ~(1ULL << bit);
+
+        status = Descend(bit - 1, remaining);
+        if (status == Exhausted && budgetHit) return BudgetExceeded;
+        return status;
+    }
+
+    const uint64_t *blockers_;
+    const uint64_t *references_;
+    size_t count_;
+    int shift_;
+    int maxSetBits_;
+
+    std::vector<uint64_t> products_;
+    std::vector<uint32_t> slotStamp_;
+    std::vector<uint64_t> slotValue_;
+    uint32_t stamp_ = 0;
+
+    uint64_t magic_ = 0;
+    int64_t nodes_ = 0;
+    std::atomic<int64_t> *budget_ = nullptr;
+    const std::atomic<bool> *stop_ = nullptr;
+};
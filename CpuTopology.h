@@ -0,0 +1,182 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "HugePageMemory.h"
+
+// CPU topology detection (packages, physical cores, SMT siblings, NUMA nodes)
+// and the thread placement policies used by the searcher.
+
+struct LogicalCpu {
+    int id;
+    int package;
+    int core;      // core id, unique only within its package
+    int node;
+    int smtIndex;  // 0 for the first hardware thread of a core, 1 for its sibling, ...
+};
+
+struct CpuTopology {
+    std::vector<LogicalCpu> cpus;
+    int packages = 1;
+    int physicalCores = 1;
+    int nodes = 1;
+
+    bool HasSmt() const { return physicalCores < int(cpus.size()); }
+};
+
+enum class AffinityPolicy { Auto, None, Compact, Scatter, Physical };
+
+inline bool ParseAffinityPolicy(const std::string &name, AffinityPolicy &policy) {
+    if (name == "auto") policy = AffinityPolicy::Auto;
+    else if (name == "none") policy = AffinityPolicy::None;
+    else if (name == "compact") policy = AffinityPolicy::Compact;
+    else if (name == "scatter") policy = AffinityPolicy::Scatter;
+    else if (name == "physical") policy = AffinityPolicy::Physical;
+    else return false;
+    return true;
+}
+
+inline const char *AffinityPolicyName(AffinityPolicy policy) {
+    switch (policy) {
+        case AffinityPolicy::Auto: return "auto";
+        case AffinityPolicy::None: return "none";
+        case AffinityPolicy::Compact: return "compact";
+        case AffinityPolicy::Scatter: return "scatter";
+        case AffinityPolicy::Physical: return "physical";
+    }
+    return "?";
+}
+
+inline CpuTopology DetectTopology() {
+    CpuTopology topology;
+    const std::string cpuRoot = "/sys/devices/system/cpu/";
+
+    std::vector<int> online = ParseSysfsList(ReadSysfsLine(cpuRoot + "online"));
+    if (online.empty()) {
+        // No sysfs: treat every hardware thread as its own core on one package
+        int count = std::max(1u, std::thread::hardware_concurrency());
+        for (int i = 0; i < count; i++)
+            online.push_back(i);
+    }
+
+    std::map<int, int> cpuNode;
+    for (int node = 0; node < NumaNodeCount(); node++)
+        for (int cpu : NumaNodeCpus(node))
+            cpuNode[cpu] = node;
+
+    for (int id : online) {
+        std::string topologyDir = cpuRoot + "cpu" + std::to_string(id) + "/topology/";
+        std::string package = ReadSysfsLine(topologyDir + "physical_package_id");
+        std::string core = ReadSysfsLine(topologyDir + "core_id");
+        std::vector<int> siblings = ParseSysfsList(ReadSysfsLine(topologyDir + "thread_siblings_list"));
+
+        LogicalCpu cpu;
+        cpu.id = id;
+        cpu.package = package.empty() ? 0 : std::atoi(package.c_str());
+        cpu.core = core.empty() ? id : std::atoi(core.c_str());
+        cpu.node = cpuNode.count(id) ? cpuNode[id] : 0;
+        cpu.smtIndex = int(std::find(siblings.begin(), siblings.end(), id) - siblings.begin());
+        if (cpu.smtIndex == int(siblings.size())) cpu.smtIndex = 0;
+        topology.cpus.push_back(cpu);
+    }
+
+    std::vector<std::pair<int, int>> cores;
+    std::vector<int> packages, nodes;
+    for (const LogicalCpu &cpu : topology.cpus) {
+        cores.push_back({cpu.package, cpu.core});
+        packages.push_back(cpu.package);
+        nodes.push_back(cpu.node);
+    }
+    for (auto *ids : {&packages, &nodes}) {
+        std::sort(ids->begin(), ids->end());
+        ids->erase(std::unique(ids->begin(), ids->end()), ids->end());
+    }
+    std::sort(cores.begin(), cores.end());
+    cores.erase(std::unique(cores.begin(), cores.end()), cores.end());
+
+    topology.packages = std::max<int>(1, packages.size());
+    topology.physicalCores = std::max<int>(1, cores.size());
+    topology.nodes = std::max<int>(1, nodes.size());
+    return topology;
+}
+
+inline void PrintTopology(const CpuTopology &topology) {
+    std::cout << "Detected topology: " << topology.cpus.size() << " logical cpus, "
+         << topology.physicalCores << " physical cores, "
+         << topology.packages << " package(s), "
+         << topology.nodes << " NUMA node(s)"
+         << (topology.HasSmt() ? ", SMT on" : ", no SMT") << "\n";
+    for (const LogicalCpu &cpu : topology.cpus)
+        std::cout << "  cpu " << cpu.id << ": package " << cpu.package << " core " << cpu.core
+             << " node " << cpu.node << " smt " << cpu.smtIndex << "\n";
+}
+
+// Order in which worker threads are assigned to logical cpus.
+//   Compact:  fill a core's SMT siblings, then the next core, then the next package
+//   Scatter:  one thread per core round-robin across nodes, SMT siblings only once
+//             every physical core is busy
+//   Physical: like scatter but never uses a second hardware thread of a core
+// Thread i runs on order[i % order.size()].
+inline std::vector<int> PlanCpuOrder(const CpuTopology &topology, AffinityPolicy policy) {
+    std::vector<LogicalCpu> cpus = topology.cpus;
+    std::vector<int> order;
+
+    if (policy == AffinityPolicy::Compact) {
+        std::sort(cpus.begin(), cpus.end(), [](const LogicalCpu &a, const LogicalCpu &b) {
+            return std::make_tuple(a.node, a.package, a.core, a.smtIndex) <
+                   std::make_tuple(b.node, b.package, b.core, b.smtIndex);
+        });
+        for (const LogicalCpu &cpu : cpus)
+            order.push_back(cpu.id);
+        return order;
+    }
+
+    // Scatter and physical: group by SMT level, then interleave nodes within a level
+    std::sort(cpus.begin(), cpus.end(), [](const LogicalCpu &a, const LogicalCpu &b) {
+        return std::make_tuple(a.smtIndex, a.node, a.package, a.core) <
+               std::make_tuple(b.smtIndex, b.node, b.package, b.core);
+    });
+    for (int smt = 0; ; smt++) {
+        std::vector<std::vector<int>> perNode(topology.nodes + 1);
+        bool any = false;
+        for (const LogicalCpu &cpu : cpus) {
+            if (cpu.smtIndex != smt) continue;
+            perNode[std::min(cpu.node, topology.nodes)].push_back(cpu.id);
+            any = true;
+        }
+        if (!any) break;
+        for (size_t i = 0; ; i++) {
+            bool placed = false;
+            for (auto &node : perNode)
+                if (i < node.size()) { order.push_back(node[i]); placed = true; }
+            if (!placed) break;
+        }
+        if (policy == AffinityPolicy::Physical) break;
+    }
+    return order;
+}
+
+// Pin the calling thread to one logical cpu; returns false if the OS refused
+inline bool PinCurrentThread(int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
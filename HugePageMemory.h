@@ -0,0 +1,196 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <new>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Huge-page backed storage and NUMA node helpers for the lookup and search tables.
+// Everything degrades to plain allocations on a single node when the kernel
+// (or the platform) does not support huge pages or NUMA.
+
+constexpr size_t HugePageSize = size_t(2) << 20;
+
+inline size_t RoundUpToHugePage(size_t bytes) {
+    return (bytes + HugePageSize - 1) & ~(HugePageSize - 1);
+}
+
+// Parse a sysfs cpu/node list such as "0-3,8-11" into individual ids
+inline std::vector<int> ParseSysfsList(const std::string &text) {
+    std::vector<int> ids;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find(',', pos);
+        if (end == std::string::npos) end = text.size();
+        std::string range = text.substr(pos, end - pos);
+        size_t dash = range.find('-');
+        if (!range.empty() && range[0] >= '0' && range[0] <= '9') {
+            int first = std::atoi(range.c_str());
+            int last = dash == std::string::npos ? first : std::atoi(range.c_str() + dash + 1);
+            for (int id = first; id <= last; id++)
+                ids.push_back(id);
+        }
+        pos = end + 1;
+    }
+    return ids;
+}
+
+inline std::string ReadSysfsLine(const std::string &path) {
+    std::ifstream file(path);
+    std::string line;
+    if (file) std::getline(file, line);
+    return line;
+}
+
+// Number of NUMA nodes the kernel reports online (1 when unknown)
+inline int NumaNodeCount() {
+    static const int count = [] {
+        std::vector<int> nodes = ParseSysfsList(ReadSysfsLine("/sys/devices/system/node/online"));
+        return nodes.empty() ? 1 : nodes.back() + 1;
+    }();
+    return count;
+}
+
+// NUMA node of the cpu the calling thread is currently running on
+inline int CurrentNumaNode() {
+#if defined(__linux__) && defined(SYS_getcpu)
+    unsigned cpu = 0, node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0 && int(node) < NumaNodeCount())
+        return int(node);
+#endif
+    return 0;
+}
+
+// Logical cpus that belong to a NUMA node
+inline std::vector<int> NumaNodeCpus(int node) {
+    return ParseSysfsList(ReadSysfsLine("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"));
+}
+
+// Ask the kernel to place a range on the given node; purely advisory
+inline void PreferNumaNode(void *address, size_t bytes, int node) {
+#if defined(__linux__) && defined(SYS_mbind)
+    if (NumaNodeCount() < 2 || node >= 64) return;
+    const int MpolPreferred = 1;
+    unsigned long nodeMask = 1UL << node;
+    syscall(SYS_mbind, address, bytes, MpolPreferred, &nodeMask, 64UL, 0U);
+#else
+    (void)address; (void)bytes; (void)node;
+#endif
+}
+
+// Fixed-size, zero-initialised array of trivially copyable T placed in 2 MB pages.
+// Tries explicit hugetlbfs pages first, then transparent huge pages via madvise,
+// then an ordinary aligned allocation.
+template<class T> class HugePageBuffer {
+public:
+    HugePageBuffer() = default;
+    explicit HugePageBuffer(size_t count, int node = -1) { Allocate(count, node); }
+    ~HugePageBuffer() { Release(); }
+
+    HugePageBuffer(const HugePageBuffer &) = delete;
+    HugePageBuffer &operator=(const HugePageBuffer &) = delete;
+
+    HugePageBuffer(HugePageBuffer &&other) noexcept { *this = std::move(other); }
+    HugePageBuffer &operator=(HugePageBuffer &&other) noexcept {
+        if (this != &other) {
+            Release();
+            data_ = other.data_; count_ = other.count_; bytes_ = other.bytes_;
+            mapped_ = other.mapped_; hugeTlb_ = other.hugeTlb_;
+            other.data_ = nullptr; other.count_ = 0; other.bytes_ = 0;
+        }
+        return *this;
+    }
+
+    void Allocate(size_t count, int node = -1) {
+        Release();
+        count_ = count;
+        bytes_ = RoundUpToHugePage(count > 0 ? count * sizeof(T) : 1);
+        void *memory = nullptr;
+#ifdef __linux__
+        memory = mmap(nullptr, bytes_, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        hugeTlb_ = memory != MAP_FAILED;
+        if (!hugeTlb_) {
+            memory = mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (memory != MAP_FAILED) madvise(memory, bytes_, MADV_HUGEPAGE);
+        }
+        mapped_ = memory != MAP_FAILED;
+        if (!mapped_) memory = nullptr;
+        if (memory && node >= 0) PreferNumaNode(memory, bytes_, node);
+#else
+        (void)node;
+#endif
+        if (!memory) {
+            memory = std::aligned_alloc(HugePageSize, bytes_);
+            if (!memory) throw std::bad_alloc();
+        }
+        data_ = static_cast<T *>(memory);
+        // First touch from the calling thread also faults the pages in on its node
+        std::memset(data_, 0, count_ * sizeof(T));
+    }
+
+    T *data() { return data_; }
+    const T *data() const { return data_; }
+    size_t size() const { return count_; }
+    bool UsesHugeTlb() const { return hugeTlb_; }
+
+    T &operator[](size_t i) { return data_[i]; }
+    const T &operator[](size_t i) const { return data_[i]; }
+    T *begin() { return data_; }
+    T *end() { return data_ + count_; }
+    const T *begin() const { return data_; }
+    const T *end() const { return data_ + count_; }
+
+private:
+    void Release() {
+        if (!data_) return;
+#ifdef __linux__
+        if (mapped_) munmap(data_, bytes_);
+        else std::free(data_);
+#else
+        std::free(data_);
+#endif
+        data_ = nullptr;
+    }
+
+    T *data_ = nullptr;
+    size_t count_ = 0;
+    size_t bytes_ = 0;
+    bool mapped_ = false;
+    bool hugeTlb_ = false;
+};
+
+// One lazily built copy of T per NUMA node. The first thread to ask for its
+// node's copy builds it, so first-touch places the pages on that node.
+template<class T> class NodeLocal {
+public:
+    using Builder = std::function<std::unique_ptr<T>(int node)>;
+
+    explicit NodeLocal(Builder builder)
+        : builder_(std::move(builder)), copies_(NumaNodeCount()), once_(NumaNodeCount()) {}
+
+    const T &ForNode(int node) {
+        std::call_once(once_[node], [&] { copies_[node] = builder_(node); });
+        return *copies_[node];
+    }
+
+    const T &Local() { return ForNode(CurrentNumaNode()); }
+
+private:
+    Builder builder_;
+    std::vector<std::unique_ptr<T>> copies_;
+    std::vector<std::once_flag> once_;
+};
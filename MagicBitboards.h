@@ -0,0 +1,631 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "BoardGeometry.h"
+#include "HugePageMemory.h"
+
+namespace magicbb {
+
+// Header-only magic bitboard library for 8x8 chess: bit helpers, mask and
+// attack generators, the magic tables and the attack lookups shared by the
+// searcher, the tests and any engine embedding them. Everything lives in
+// namespace magicbb, as do Position.h, AttackMap.h and OccupancyCorpus.h.
+//
+//   InitializeAttackTables();               // once, before any lookup
+//   attacks<Piece::Rook>(sq, occupancy);    // runtime square
+//   attacks<Piece::Bishop, C1>(occupancy);  // square known at compile time:
+//                                           // mask, magic, shift and table offset
+//                                           // are folded into immediates
+//   mobility<Piece::Rook>(sq, occupancy);   // attack popcount and counts within
+//                                           // MobilityRegions, same index
+
+using Bitboard = uint64_t;
+
+enum class Piece { Rook, Bishop, Queen };
+
+enum Square : int {
+    A1, B1, C1, D1, E1, F1, G1, H1,
+    A2, B2, C2, D2, E2, F2, G2, H2,
+    A3, B3, C3, D3, E3, F3, G3, H3,
+    A4, B4, C4, D4, E4, F4, G4, H4,
+    A5, B5, C5, D5, E5, F5, G5, H5,
+    A6, B6, C6, D6, E6, F6, G6, H6,
+    A7, B7, C7, D7, E7, F7, G7, H7,
+    A8, B8, C8, D8, E8, F8, G8, H8
+};
+
+// Utility functions
+template<class T> inline T BIT(const T &x) {
+    return (T(1) << x);
+}
+
+template<class T> inline bool IsBitSet(const T &object, int bitIndex) {
+    return (object >> bitIndex) & 1;
+}
+
+template<class T> inline void SetBit(T &object, int bitIndex) {
+    object |= BIT<T>(bitIndex);
+}
+
+// Count bits in a bitboard (popcount)
+inline int CountBits(Bitboard b) {
+    return __builtin_popcountll(b);
+}
+
+// Print a bitboard in a chessboard format
+inline void PrintBitboard(Bitboard bb, const std::string& title = "") {
+    if (!title.empty()) {
+        std::cout << title << ":\n";
+    }
+    
+    for (int row = 7; row >= 0; row--) {
+        std::cout << row + 1 << " ";
+        for (int col = 0; col < 8; col++) {
+            int square = row * 8 + col;
+            std::cout << (IsBitSet(bb, square) ? "x " : ". ");
+        }
+        std::cout << "\n";
+    }
+    std::cout << "  a b c d e f g h\n\n";
+}
+
+// Generate rook moves mask (excluding edges)
+constexpr Bitboard GenerateRookMovesMask(int sqr) {
+    return GenerateRookMask<Chess8x8>(sqr);
+}
+
+// Generate bishop moves mask (excluding edges)
+constexpr Bitboard GenerateBishopMovesMask(int sqr) {
+    return GenerateBishopMask<Chess8x8>(sqr);
+}
+
+// Generate actual rook attacks considering blockers (slow reference version)
+constexpr Bitboard GenerateRookAttacks(int sq, Bitboard blockers) {
+    return GenerateRookAttacksOn<Chess8x8>(sq, blockers);
+}
+
+// Generate actual bishop attacks considering blockers (slow reference version)
+constexpr Bitboard GenerateBishopAttacks(int sq, Bitboard blockers) {
+    return GenerateBishopAttacksOn<Chess8x8>(sq, blockers);
+}
+
+// Magic number structure
+struct MagicEntry {
+    uint64_t magic;
+    int shift;
+    int tableSize;
+};
+
+inline constexpr MagicEntry RookMagics[64] = {
+    {0x0080064000201081, 52, 4096},
+    {0x0040021001406000, 53, 2048},
+    {0x2080200070001880, 53, 2048},
+    {0x8100100100542088, 53, 2048},
+    {0x8e00042008120110, 53, 2048},
+    {0x4b00082400021100, 53, 2048},
+    {0x02000200040800b1, 53, 2048},
+    {0x0500028608402100, 52, 4096},
+    {0x9800800299214000, 53, 2048},
+    {0x0402002200810050, 54, 1024},
+    {0x0005001045002001, 54, 1024},
+    {0x0004801800d00280, 54, 1024},
+    {0x002900080101504c, 54, 1024},
+    {0x100d000c00880300, 54, 1024},
+    {0x2023808001003a00, 54, 1024},
+    {0x0101000182224100, 53, 2048},
+    {0x0004808000214000, 53, 2048},
+    {0x0011020049220080, 54, 1024},
+    {0x6288220040108203, 54, 1024},
+    {0x0222818008025002, 54, 1024},
+    {0x4004008080040800, 54, 1024},
+    {0x0500808012000400, 54, 1024},
+    {0x4012050100020004, 54, 1024},
+    {0x00000a0001840445, 53, 2048},
+    {0x4200800180284002, 53, 2048},
+    {0x001080a100400500, 54, 1024},
+    {0x0402500480200480, 54, 1024},
+    {0x2100100280080081, 54, 1024},
+    {0x0048010100110c08, 54, 1024},
+    {0x6000040080800200, 54, 1024},
+    {0x0226088400010210, 54, 1024},
+    {0x0018802680014100, 53, 2048},
+    {0x3000804000801024, 53, 2048},
+    {0x8110022001404008, 54, 1024},
+    {0x0800500080806000, 54, 1024},
+    {0x0880081042002200, 54, 1024},
+    {0xa800850091000800, 54, 1024},
+    {0x0101120080800400, 54, 1024},
+    {0x0000100804000122, 54, 1024},
+    {0x0004004286000c01, 53, 2048},
+    {0x0028400280228000, 53, 2048},
+    {0x0300c00081010020, 54, 1024},
+    {0x4020001000858020, 54, 1024},
+    {0x1002000810420020, 54, 1024},
+    {0x03820020180e0010, 54, 1024},
+    {0x0404040002008080, 54, 1024},
+    {0x3000aa1810040015, 54, 1024},
+    {0x4100010064920004, 53, 2048},
+    {0x6100204008801180, 53, 2048},
+    {0x010c2010004000c0, 54, 1024},
+    {0x8040402003001900, 54, 1024},
+    {0x0302001008224200, 54, 1024},
+    {0x4201000800308700, 54, 1024},
+    {0x0010800400020080, 54, 1024},
+    {0x2004500208031400, 54, 1024},
+    {0x0000800100005280, 53, 2048},
+    {0x00a02202450080b2, 52, 4096},
+    {0x808a220700401282, 53, 2048},
+    {0x2200200040090011, 53, 2048},
+    {0x2201000409201001, 53, 2048},
+    {0x1002010c08102042, 53, 2048},
+    {0x1d01000804000201, 53, 2048},
+    {0x01000802011000cc, 53, 2048},
+    {0x800081002088c402, 52, 4096}
+};
+
+inline constexpr MagicEntry BishopMagics[64] = {
+    {0x4040082704028010, 58, 64},
+    {0x000218c813004087, 59, 32},
+    {0x40849c0082004061, 59, 32},
+    {0xd012408102000840, 59, 32},
+    {0x00820a1000000000, 59, 32},
+    {0x0201092031000000, 59, 32},
+    {0x4002021082090403, 59, 32},
+    {0x0001004804040a41, 58, 64},
+    {0x000a292208520402, 59, 32},
+    {0x008014051c250e03, 59, 32},
+    {0x00501c0802014800, 59, 32},
+    {0x830104104a002002, 59, 32},
+    {0x0100908820201030, 59, 32},
+    {0x00c0044108400214, 59, 32},
+    {0x10007400a208600d, 59, 32},
+    {0x0000012101105001, 59, 32},
+    {0x0204082254840802, 59, 32},
+    {0x1004003004088420, 59, 32},
+    {0x0461120802006200, 57, 128},
+    {0x0104830802004100, 57, 128},
+    {0x2404028480a00000, 57, 128},
+    {0x4402000088040220, 57, 128},
+    {0x0082000103092189, 59, 32},
+    {0x00820c0041442c00, 59, 32},
+    {0x001018a4414a0400, 59, 32},
+    {0x0002060650040800, 59, 32},
+    {0xc0a8880010004550, 57, 128},
+    {0x4008080042620020, 55, 512},
+    {0x3201001081004001, 55, 512},
+    {0x004040806510100c, 57, 128},
+    {0x6048028201040101, 59, 32},
+    {0x1000408382060100, 59, 32},
+    {0x0011201005220400, 59, 32},
+    {0x090082100c200404, 59, 32},
+    {0x3020402800100d40, 57, 128},
+    {0x0082008400020120, 55, 512},
+    {0x00040100700c00c0, 55, 512},
+    {0x8210204080011004, 57, 128},
+    {0x0f07020600041100, 59, 32},
+    {0x0003040020408210, 59, 32},
+    {0xea0c023842002c10, 59, 32},
+    {0x0494012410014a01, 59, 32},
+    {0x2017004022003004, 57, 128},
+    {0x0002401414000800, 57, 128},
+    {0x4404400091000200, 57, 128},
+    {0x0624008401008810, 57, 128},
+    {0x0d0210060a000280, 59, 32},
+    {0x0104440042000040, 59, 32},
+    {0x0002080212d08000, 59, 32},
+    {0x0001410828220024, 59, 32},
+    {0x000000c200d01c20, 59, 32},
+    {0x00000000840c2000, 59, 32},
+    {0x000264080b040040, 59, 32},
+    {0x0018604431020470, 59, 32},
+    {0x0140022881010414, 59, 32},
+    {0x508810118a004981, 59, 32},
+    {0x8400841101012012, 58, 64},
+    {0x2020008205b00400, 59, 32},
+    {0xc010071042080400, 59, 32},
+    {0x00044080649c0400, 59, 32},
+    {0x0090502051120202, 59, 32},
+    {0x2002002002060a00, 59, 32},
+    {0xf010905050008284, 59, 32},
+    {0x00848804b8018100, 58, 64}
+
+};
+
+
+// Masks for rook and bishop, computed at compile time
+template<Piece P> constexpr std::array<Bitboard, 64> GenerateMasks() {
+    std::array<Bitboard, 64> masks{};
+    for (int sq = 0; sq < 64; sq++)
+        masks[sq] = P == Piece::Bishop ? GenerateBishopMovesMask(sq) : GenerateRookMovesMask(sq);
+    return masks;
+}
+
+constexpr std::array<Bitboard, 64> RookMasks = GenerateMasks<Piece::Rook>();
+constexpr std::array<Bitboard, 64> BishopMasks = GenerateMasks<Piece::Bishop>();
+
+// Attack tables: every rook and bishop square lives in one combined huge-page
+// buffer so lookups stay within a handful of dTLB entries
+struct AttackTableSlice {
+    size_t offset;
+    int size;
+};
+
+// Lay out rook squares first, then bishop squares; squares without a magic
+// get an empty slice and use the fallback
+constexpr std::array<AttackTableSlice, 128> ComputeAttackTableSlices() {
+    std::array<AttackTableSlice, 128> slices{};
+    size_t totalSize = 0;
+    for (int i = 0; i < 128; i++) {
+        const MagicEntry &magic = i < 64 ? RookMagics[i] : BishopMagics[i - 64];
+        int size = magic.shift == 64 ? 0 : magic.tableSize;
+        slices[i] = {totalSize, size};
+        totalSize += size;
+    }
+    return slices;
+}
+
+constexpr std::array<AttackTableSlice, 128> AttackTableSlices = ComputeAttackTableSlices();
+constexpr size_t AttackTableSize = AttackTableSlices[127].offset + AttackTableSlices[127].size;
+
+template<Piece P> constexpr const MagicEntry &MagicFor(int sq) {
+    return P == Piece::Bishop ? BishopMagics[sq] : RookMagics[sq];
+}
+
+template<Piece P> constexpr Bitboard MaskFor(int sq) {
+    return P == Piece::Bishop ? BishopMasks[sq] : RookMasks[sq];
+}
+
+template<Piece P> constexpr const AttackTableSlice &SliceFor(int sq) {
+    return AttackTableSlices[(P == Piece::Bishop ? 64 : 0) + sq];
+}
+
+// Per-piece views of the combined layout, indexed by square
+struct AttackSliceView {
+    int base;
+    constexpr const AttackTableSlice &operator[](int sq) const { return AttackTableSlices[base + sq]; }
+};
+
+constexpr AttackSliceView RookAttackSlices{0};
+constexpr AttackSliceView BishopAttackSlices{64};
+
+inline HugePageBuffer<Bitboard> AttackTable;
+
+template<Piece P> inline void FillAttackTable(int sq) {
+    const AttackTableSlice &slice = SliceFor<P>(sq);
+    if (slice.size == 0) {
+        // Skip if magic not found for this square
+        return;
+    }
+    
+    Bitboard mask = MaskFor<P>(sq);
+    const MagicEntry &magic = MagicFor<P>(sq);
+    Bitboard *table = AttackTable.data() + slice.offset;
+    
+    // Generate all possible blocker configurations using Carry-Rippler method
+    Bitboard blockers = 0;
+    do {
+        // Calculate index using magic multiplication
+        int index = (blockers * magic.magic) >> magic.shift;
+        
+        // Generate and store attacks for this blocker configuration
+        if (index >= 0 && index < slice.size) {
+            table[index] = P == Piece::Bishop ? GenerateBishopAttacks(sq, blockers)
+                                              : GenerateRookAttacks(sq, blockers);
+        }
+        
+        // Get next subset of blockers
+        blockers = (blockers - mask) & mask;
+    } while (blockers != 0);
+}
+
+// Mobility tables: one entry per attack table slot with the popcount of its attack
+// set and the counts inside a few fixed region masks, so evaluation gets mobility
+// from the same magic index with one 4-byte load instead of several popcounts
+constexpr int MobilityRegionCount = 3;
+
+struct MobilityEntry {
+    uint8_t total;
+    std::array<uint8_t, MobilityRegionCount> regions;
+};
+
+// Rook and bishop rays never overlap, so queen counts are the sum of both
+constexpr MobilityEntry operator+(MobilityEntry a, const MobilityEntry &b) {
+    a.total += b.total;
+    for (int i = 0; i < MobilityRegionCount; i++) a.regions[i] += b.regions[i];
+    return a;
+}
+
+// Default regions: the 4x4 centre, white's half and black's half
+constexpr std::array<Bitboard, MobilityRegionCount> DefaultMobilityRegions = {
+    0x00003C3C3C3C0000ULL, 0x00000000FFFFFFFFULL, 0xFFFFFFFF00000000ULL
+};
+
+inline std::array<Bitboard, MobilityRegionCount> MobilityRegions = DefaultMobilityRegions;
+inline HugePageBuffer<MobilityEntry> MobilityTable;
+
+inline MobilityEntry CountMobility(Bitboard attacks) {
+    MobilityEntry entry{uint8_t(CountBits(attacks)), {}};
+    for (int i = 0; i < MobilityRegionCount; i++)
+        entry.regions[i] = uint8_t(CountBits(attacks & MobilityRegions[i]));
+    return entry;
+}
+
+// Fill MobilityTable from the attack table for the current MobilityRegions
+inline void BuildMobilityTable() {
+    MobilityTable.Allocate(AttackTableSize, CurrentNumaNode());
+    for (size_t i = 0; i < AttackTableSize; i++)
+        MobilityTable[i] = CountMobility(AttackTable[i]);
+}
+
+// Change the region masks; rebuilds the mobility table if the attack tables
+// already exist. Not safe while other threads are looking up mobility.
+inline void SetMobilityRegions(const std::array<Bitboard, MobilityRegionCount> &regions) {
+    MobilityRegions = regions;
+    if (AttackTable.data()) BuildMobilityTable();
+}
+
+// Lookups read the tables directly; debug builds catch a missing InitializeAttackTables()
+inline void AssertTablesReady() {
+    assert(AttackTable.data() && MobilityTable.data() && "InitializeAttackTables() must be called first");
+}
+
+// Initialize attack tables
+inline void InitializeAttackTables() {
+    AttackTable.Allocate(AttackTableSize, CurrentNumaNode());
+    for (int sq = 0; sq < 64; sq++) {
+        FillAttackTable<Piece::Rook>(sq);
+        FillAttackTable<Piece::Bishop>(sq);
+    }
+    BuildMobilityTable();
+}
+
+// Slot of a lookup in the combined layout: AttackTable[slot] holds the attack
+// set and MobilityTable[slot] its counts
+template<Piece P> inline size_t AttackSlot(int sq, Bitboard occupancy) {
+    const MagicEntry &magic = MagicFor<P>(sq);
+    return SliceFor<P>(sq).offset + (((occupancy & MaskFor<P>(sq)) * magic.magic) >> magic.shift);
+}
+
+// Fast lookup for a runtime square; the magics must be valid for every square
+template<Piece P> inline Bitboard attacks(int sq, Bitboard occupancy) {
+    if constexpr (P == Piece::Queen) {
+        return attacks<Piece::Rook>(sq, occupancy) | attacks<Piece::Bishop>(sq, occupancy);
+    } else {
+        AssertTablesReady();
+        return AttackTable[AttackSlot<P>(sq, occupancy)];
+    }
+}
+
+// Mobility counts of a runtime square, from the same index as attacks<P>
+template<Piece P> inline MobilityEntry mobility(int sq, Bitboard occupancy) {
+    if constexpr (P == Piece::Queen) {
+        return mobility<Piece::Rook>(sq, occupancy) + mobility<Piece::Bishop>(sq, occupancy);
+    } else {
+        AssertTablesReady();
+        return MobilityTable[AttackSlot<P>(sq, occupancy)];
+    }
+}
+
+// Lookup for a square known at compile time: mask, magic, shift and table
+// offset are constants, leaving one multiply, one shift and one load
+template<Piece P, Square S> inline Bitboard attacks(Bitboard occupancy) {
+    if constexpr (P == Piece::Queen) {
+        return attacks<Piece::Rook, S>(occupancy) | attacks<Piece::Bishop, S>(occupancy);
+    } else {
+        constexpr Bitboard mask = MaskFor<P>(S);
+        constexpr uint64_t magic = MagicFor<P>(S).magic;
+        constexpr int shift = MagicFor<P>(S).shift;
+        constexpr size_t offset = SliceFor<P>(S).offset;
+        static_assert(shift < 64, "no magic for this square");
+        AssertTablesReady();
+        return AttackTable[offset + (((occupancy & mask) * magic) >> shift)];
+    }
+}
+
+template<Piece P, Square S> inline MobilityEntry mobility(Bitboard occupancy) {
+    if constexpr (P == Piece::Queen) {
+        return mobility<Piece::Rook, S>(occupancy) + mobility<Piece::Bishop, S>(occupancy);
+    } else {
+        constexpr Bitboard mask = MaskFor<P>(S);
+        constexpr uint64_t magic = MagicFor<P>(S).magic;
+        constexpr int shift = MagicFor<P>(S).shift;
+        constexpr size_t offset = SliceFor<P>(S).offset;
+        static_assert(shift < 64, "no magic for this square");
+        AssertTablesReady();
+        return MobilityTable[offset + (((occupancy & mask) * magic) >> shift)];
+    }
+}
+
+// Get rook attacks using magic bitboards
+inline Bitboard GetRookAttacks(int sq, Bitboard occupancy) {
+    // Get relevant blockers (only those on the mask)
+    Bitboard blockers = occupancy & RookMasks[sq];
+    
+    // Calculate index using magic multiplication
+    int index = (blockers * RookMagics[sq].magic) >> RookMagics[sq].shift;
+    
+    // Return precomputed attacks with bounds checking
+    if (index >= 0 && index < RookAttackSlices[sq].size) {
+        AssertTablesReady();
+        return AttackTable[RookAttackSlices[sq].offset + index];
+    }
+    
+    // Fallback if index is out of bounds
+    return GenerateRookAttacks(sq, occupancy);
+}
+
+// Get bishop attacks using magic bitboards
+inline Bitboard GetBishopAttacks(int sq, Bitboard occupancy) {
+    // Get relevant blockers (only those on the mask)
+    Bitboard blockers = occupancy & BishopMasks[sq];
+    
+    // Calculate index using magic multiplication
+    int index = (blockers * BishopMagics[sq].magic) >> BishopMagics[sq].shift;
+    
+    // Return precomputed attacks with bounds checking
+    if (index >= 0 && index < BishopAttackSlices[sq].size) {
+        AssertTablesReady();
+        return AttackTable[BishopAttackSlices[sq].offset + index];
+    }
+    
+    // Fallback if index is out of bounds
+    return GenerateBishopAttacks(sq, occupancy);
+}
+
+// Mobility counterparts of GetRookAttacks / GetBishopAttacks, with the same fallback
+inline MobilityEntry GetRookMobility(int sq, Bitboard occupancy) {
+    int index = ((occupancy & RookMasks[sq]) * RookMagics[sq].magic) >> RookMagics[sq].shift;
+    if (index >= 0 && index < RookAttackSlices[sq].size) {
+        AssertTablesReady();
+        return MobilityTable[RookAttackSlices[sq].offset + index];
+    }
+    return CountMobility(GenerateRookAttacks(sq, occupancy));
+}
+
+inline MobilityEntry GetBishopMobility(int sq, Bitboard occupancy) {
+    int index = ((occupancy & BishopMasks[sq]) * BishopMagics[sq].magic) >> BishopMagics[sq].shift;
+    if (index >= 0 && index < BishopAttackSlices[sq].size) {
+        AssertTablesReady();
+        return MobilityTable[BishopAttackSlices[sq].offset + index];
+    }
+    return CountMobility(GenerateBishopAttacks(sq, occupancy));
+}
+
+// Get queen attacks (combination of rook and bishop)
+inline Bitboard GetQueenAttacks(int sq, Bitboard occupancy) {
+    return GetRookAttacks(sq, occupancy) | GetBishopAttacks(sq, occupancy);
+}
+
+// Squares attacked through the first of `blockers` on each ray: the extra squares
+// a slider would see if those pieces were lifted. blockers is normally a subset
+// of occupancy, e.g. the own pieces when looking for pinned ones.
+template<Piece P> inline Bitboard xrayAttacks(int sq, Bitboard occupancy, Bitboard blockers) {
+    Bitboard direct = attacks<P>(sq, occupancy);
+    return direct ^ attacks<P>(sq, occupancy ^ (blockers & direct));
+}
+
+inline Bitboard GetRookXrayAttacks(int sq, Bitboard occupancy, Bitboard blockers) {
+    return xrayAttacks<Piece::Rook>(sq, occupancy, blockers);
+}
+
+inline Bitboard GetBishopXrayAttacks(int sq, Bitboard occupancy, Bitboard blockers) {
+    return xrayAttacks<Piece::Bishop>(sq, occupancy, blockers);
+}
+
+// Between[a][b]: squares strictly between a and b; Line[a][b]: the whole rank,
+// file or diagonal through both (a and b included). Both are 0 when a and b
+// are not aligned.
+constexpr std::array<std::array<Bitboard, 64>, 64> GenerateLineTable(bool between) {
+    std::array<std::array<Bitboard, 64>, 64> table{};
+    for (int a = 0; a < 64; a++) {
+        for (int b = 0; b < 64; b++) {
+            Bitboard bitA = Bitboard(1) << a, bitB = Bitboard(1) << b;
+            for (bool isBishop : {false, true}) {
+                auto slide = isBishop ? GenerateBishopAttacks : GenerateRookAttacks;
+                if (!(slide(a, 0) & bitB)) continue;
+                table[a][b] = between ? slide(a, bitB) & slide(b, bitA)
+                                      : (slide(a, 0) & slide(b, 0)) | bitA | bitB;
+            }
+        }
+    }
+    return table;
+}
+
+constexpr std::array<std::array<Bitboard, 64>, 64> Between = GenerateLineTable(true);
+constexpr std::array<std::array<Bitboard, 64>, 64> Line = GenerateLineTable(false);
+
+// Compressed attack tables: each square keeps a dictionary of its distinct attack
+// sets, and the magic-indexed table only stores a narrow index into it.
+// A rook square has at most 144 distinct attack sets, so 8-bit indices suffice
+// for chess; 16-bit indices are kept for magic sets with larger dictionaries.
+template<class IndexType> struct CompactAttackTable {
+    std::vector<IndexType> indices;       // every square's index table, back to back
+    std::vector<Bitboard> dictionary;     // every square's distinct attack sets, back to back
+    std::array<uint32_t, 64> indexOffset;
+    std::array<uint32_t, 64> dictionaryOffset;
+    
+    // Build from the flat table; fails if a square has more sets than IndexType can address
+    bool Build(const AttackSliceView &slices) {
+        indices.clear();
+        dictionary.clear();
+        for (int sq = 0; sq < 64; sq++) {
+            indexOffset[sq] = indices.size();
+            dictionaryOffset[sq] = dictionary.size();
+            
+            std::unordered_map<Bitboard, size_t> known;
+            const Bitboard *flat = AttackTable.data() + slices[sq].offset;
+            for (int slot = 0; slot < slices[sq].size; slot++) {
+                // Unused slots hold 0 and are never looked up; they share entry 0
+                auto it = known.find(flat[slot]);
+                size_t entry = 0;
+                if (it != known.end()) {
+                    entry = it->second;
+                } else if (flat[slot] != 0 || known.empty()) {
+                    entry = known.size();
+                    known[flat[slot]] = entry;
+                    dictionary.push_back(flat[slot]);
+                }
+                if (entry > std::numeric_limits<IndexType>::max()) return false;
+                indices.push_back(static_cast<IndexType>(entry));
+            }
+        }
+        return true;
+    }
+    
+    Bitboard Lookup(int sq, int index) const {
+        assert(!indices.empty() && "InitializeCompactAttackTables() must be called first");
+        return dictionary[dictionaryOffset[sq] + indices[indexOffset[sq] + index]];
+    }
+    
+    size_t Bytes() const {
+        return indices.size() * sizeof(IndexType) + dictionary.size() * sizeof(Bitboard);
+    }
+};
+
+template<class IndexType> inline CompactAttackTable<IndexType> CompactRookAttackTable;
+template<class IndexType> inline CompactAttackTable<IndexType> CompactBishopAttackTable;
+
+// Initialize the optional compressed layouts; call after InitializeAttackTables
+inline bool InitializeCompactAttackTables() {
+    return CompactRookAttackTable<uint8_t>.Build(RookAttackSlices) &&
+           CompactBishopAttackTable<uint8_t>.Build(BishopAttackSlices) &&
+           CompactRookAttackTable<uint16_t>.Build(RookAttackSlices) &&
+           CompactBishopAttackTable<uint16_t>.Build(BishopAttackSlices);
+}
+
+// Get rook attacks through the compressed layout
+template<class IndexType> inline Bitboard GetRookAttacksCompact(int sq, Bitboard occupancy) {
+    Bitboard blockers = occupancy & RookMasks[sq];
+    int index = (blockers * RookMagics[sq].magic) >> RookMagics[sq].shift;
+    
+    if (index >= 0 && index < RookAttackSlices[sq].size) {
+        return CompactRookAttackTable<IndexType>.Lookup(sq, index);
+    }
+    
+    // Fallback if index is out of bounds
+    return GenerateRookAttacks(sq, occupancy);
+}
+
+// Get bishop attacks through the compressed layout
+template<class IndexType> inline Bitboard GetBishopAttacksCompact(int sq, Bitboard occupancy) {
+    Bitboard blockers = occupancy & BishopMasks[sq];
+    int index = (blockers * BishopMagics[sq].magic) >> BishopMagics[sq].shift;
+    
+    if (index >= 0 && index < BishopAttackSlices[sq].size) {
+        return CompactBishopAttackTable<IndexType>.Lookup(sq, index);
+    }
+    
+    // Fallback if index is out of bounds
+    return GenerateBishopAttacks(sq, occupancy);
+}
+
+}  // namespace magicbb
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "BoardGeometry.h"
+
+// Pool of valid magics per (piece, square, shift), kept by the searcher when it
+// keeps going after the first hit, and stored in a compact binary file for table
+// packing and trimming tools.
+//
+// Each record notes the highest slot it uses (a table can be trimmed to
+// maxIndex + 1 entries), its constructive collisions (blocker subsets that share
+// a slot with another subset of the same attack set) and a bitmap of the slots
+// it leaves empty (where another square's table could be overlapped). Two magics
+// that send every blocker subset to the same slot build the same table, so the
+// pools deduplicate on a hash of that mapping rather than on the magic itself.
+//
+// File layout, little endian: "MAGICDB2", uint8 files, uint8 ranks, uint16 0,
+// uint32 record count, then per record: uint64 magic, uint64 mapping hash, uint8
+// isBishop, uint8 square, uint8 shift, uint8 0, uint32 maxIndex, uint32
+// constructive collisions, followed by the empty-slot bitmap as
+// ceil(2^(64 - shift) / 64) uint64 words.
+
+struct MagicRecord {
+    uint64_t magic = 0;
+    uint64_t mappingHash = 0;           // FNV-1a over the slot of each blocker subset
+    bool isBishop = false;
+    int square = 0;
+    int shift = 64;
+    uint32_t maxIndex = 0;
+    uint32_t constructiveCollisions = 0;
+    std::vector<uint64_t> emptySlots;   // bit i set: slot i is never used
+
+    int IndexBits() const { return 64 - shift; }
+    size_t TableSize() const { return size_t(1) << IndexBits(); }
+    size_t EmptyCount() const {
+        size_t count = 0;
+        for (uint64_t word : emptySlots) count += __builtin_popcountll(word);
+        return count;
+    }
+    bool IsEmpty(size_t slot) const { return (emptySlots[slot >> 6] >> (slot & 63)) & 1; }
+
+    // Preferred first when a pool is full: trims shorter, then leaves more room to overlap
+    bool BetterThan(const MagicRecord &other) const {
+        if (maxIndex != other.maxIndex) return maxIndex < other.maxIndex;
+        if (EmptyCount() != other.EmptyCount()) return EmptyCount() > other.EmptyCount();
+        return magic < other.magic;
+    }
+};
+
+// Annotate a magic that is already known to be collision free for this square;
+// blockers holds every blocker subset of the square's mask. Since the magic is
+// valid, every shared slot is a constructive collision.
+template<class Word>
+MagicRecord AnnotateMagic(bool isBishop, int square, uint64_t magic, int shift,
+                          const Word *blockers, size_t count) {
+    MagicRecord record;
+    record.magic = magic;
+    record.isBishop = isBishop;
+    record.square = square;
+    record.shift = shift;
+    std::vector<bool> used(record.TableSize(), false);
+    record.mappingHash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < count; i++) {
+        size_t index = MagicHash(blockers[i], magic) >> shift;
+        record.mappingHash = (record.mappingHash ^ index) * 0x100000001b3ull;
+        if (used[index]) record.constructiveCollisions++;
+        used[index] = true;
+        record.maxIndex = std::max<uint32_t>(record.maxIndex, uint32_t(index));
+    }
+    record.emptySlots.assign((record.TableSize() + 63) / 64, 0);
+    for (size_t slot = 0; slot < used.size(); slot++)
+        if (!used[slot]) record.emptySlots[slot >> 6] |= uint64_t(1) << (slot & 63);
+    return record;
+}
+
+class MagicDatabase {
+public:
+    explicit MagicDatabase(int files = 8, int ranks = 8, size_t capacity = 64)
+        : files_(files), ranks_(ranks), capacity_(capacity) {}
+
+    int Files() const { return files_; }
+    int Ranks() const { return ranks_; }
+    size_t Capacity() const { return capacity_; }
+    void SetCapacity(size_t capacity) { capacity_ = capacity; }
+
+    // Add a record to its (piece, square, shift) pool. Records with the same index
+    // mapping as one already pooled are ignored; a full pool keeps its `capacity`
+    // best records. Returns true if the record was kept.
+    bool Add(const MagicRecord &record) {
+        std::vector<MagicRecord> &pool = pools_[Key(record.isBishop, record.square, record.shift)];
+        for (const MagicRecord &existing : pool)
+            if (existing.mappingHash == record.mappingHash) return false;
+        if (pool.size() >= capacity_) {
+            auto worst = std::max_element(pool.begin(), pool.end(), [](const MagicRecord &a, const MagicRecord &b) {
+                return a.BetterThan(b);
+            });
+            if (worst == pool.end() || !record.BetterThan(*worst)) return false;
+            *worst = record;
+        } else {
+            pool.push_back(record);
+        }
+        std::sort(pool.begin(), pool.end(), [](const MagicRecord &a, const MagicRecord &b) { return a.BetterThan(b); });
+        return true;
+    }
+
+    // Records for one square and shift, best first (empty if none)
+    const std::vector<MagicRecord> &Query(bool isBishop, int square, int shift) const {
+        static const std::vector<MagicRecord> none;
+        auto it = pools_.find(Key(isBishop, square, shift));
+        return it == pools_.end() ? none : it->second;
+    }
+
+    // Shifts with at least one record for a square, largest (smallest table) first
+    std::vector<int> Shifts(bool isBishop, int square) const {
+        std::vector<int> shifts;
+        for (const auto &pool : pools_)
+            if (std::get<0>(pool.first) == isBishop && std::get<1>(pool.first) == square && !pool.second.empty())
+                shifts.push_back(std::get<2>(pool.first));
+        std::sort(shifts.rbegin(), shifts.rend());
+        return shifts;
+    }
+
+    // Size of the (piece, square, shift) pool a record would go into
+    size_t PoolSize(bool isBishop, int square, int shift) const { return Query(isBishop, square, shift).size(); }
+
+    size_t RecordCount() const {
+        size_t count = 0;
+        for (const auto &pool : pools_) count += pool.second.size();
+        return count;
+    }
+
+    bool Save(const std::string &path) const {
+        std::string temporary = path + ".tmp";
+        FILE *file = std::fopen(temporary.c_str(), "wb");
+        if (!file) return false;
+        bool ok = std::fwrite("MAGICDB2", 1, 8, file) == 8;
+        uint8_t geometry[4] = {uint8_t(files_), uint8_t(ranks_), 0, 0};
+        ok = ok && std::fwrite(geometry, 1, 4, file) == 4 && WriteLittleEndian(file, RecordCount(), 4);
+        for (const auto &pool : pools_) {
+            for (const MagicRecord &record : pool.second) {
+                uint8_t fields[4] = {uint8_t(record.isBishop), uint8_t(record.square), uint8_t(record.shift), 0};
+                ok = ok && WriteLittleEndian(file, record.magic, 8) && WriteLittleEndian(file, record.mappingHash, 8) &&
+                     std::fwrite(fields, 1, 4, file) == 4 &&
+                     WriteLittleEndian(file, record.maxIndex, 4) &&
+                     WriteLittleEndian(file, record.constructiveCollisions, 4);
+                for (uint64_t word : record.emptySlots)
+                    ok = ok && WriteLittleEndian(file, word, 8);
+            }
+        }
+        ok = std::fclose(file) == 0 && ok;
+        // Replace the old file only once the new one is complete
+        return ok && std::rename(temporary.c_str(), path.c_str()) == 0;
+    }
+
+    // Merge the records of a file into this database; false if it is missing or malformed
+    bool Load(const std::string &path) {
+        FILE *file = std::fopen(path.c_str(), "rb");
+        if (!file) return false;
+        char tag[8];
+        uint8_t geometry[4];
+        uint64_t count = 0;
+        bool ok = std::fread(tag, 1, 8, file) == 8 && std::string(tag, 8) == "MAGICDB2" &&
+                  std::fread(geometry, 1, 4, file) == 4 && ReadLittleEndian(file, count, 4) &&
+                  geometry[0] == files_ && geometry[1] == ranks_;
+        for (uint64_t i = 0; ok && i < count; i++) {
+            MagicRecord record;
+            uint8_t fields[4];
+            uint64_t maxIndex = 0, collisions = 0;
+            ok = ReadLittleEndian(file, record.magic, 8) && ReadLittleEndian(file, record.mappingHash, 8) &&
+                 std::fread(fields, 1, 4, file) == 4 &&
+                 ReadLittleEndian(file, maxIndex, 4) && ReadLittleEndian(file, collisions, 4) &&
+                 fields[1] < files_ * ranks_ && fields[2] > 32 && fields[2] < 64;
+            if (!ok) break;
+            record.isBishop = fields[0] != 0;
+            record.square = fields[1];
+            record.shift = fields[2];
+            record.maxIndex = uint32_t(maxIndex);
+            record.constructiveCollisions = uint32_t(collisions);
+            record.emptySlots.resize((record.TableSize() + 63) / 64);
+            for (uint64_t &word : record.emptySlots)
+                ok = ok && ReadLittleEndian(file, word, 8);
+            if (ok) Add(record);
+        }
+        std::fclose(file);
+        return ok;
+    }
+
+private:
+    // Integers are stored little endian whatever the host order
+    static bool WriteLittleEndian(FILE *file, uint64_t value, int bytes) {
+        uint8_t buffer[8];
+        for (int i = 0; i < bytes; i++) buffer[i] = uint8_t(value >> (8 * i));
+        return std::fwrite(buffer, 1, bytes, file) == size_t(bytes);
+    }
+
+    static bool ReadLittleEndian(FILE *file, uint64_t &value, int bytes) {
+        uint8_t buffer[8];
+        if (std::fread(buffer, 1, bytes, file) != size_t(bytes)) return false;
+        value = 0;
+        for (int i = 0; i < bytes; i++) value |= uint64_t(buffer[i]) << (8 * i);
+        return true;
+    }
+
+    using PoolKey = std::tuple<bool, int, int>;
+    static PoolKey Key(bool isBishop, int square, int shift) { return PoolKey(isBishop, square, shift); }
+
+    int files_, ranks_;
+    size_t capacity_;
+    std::map<PoolKey, std::vector<MagicRecord>> pools_;
+};
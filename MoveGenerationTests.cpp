@@ -6,413 +6,106 @@
 #include <assert.h>
 #include <random>
 #include <chrono>
+#include <iomanip>
+#include <string>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
 
-using namespace std;
-
-using Bitboard = uint64_t;
-
-// Magic number structure
-struct MagicEntry {
-    uint64_t magic;
-    int shift;
-    int tableSize;
-};
+#include "AttackMap.h"
+#include "ConstructiveSearch.h"
+#include "MagicDatabase.h"
+#include "MagicBitboards.h"
+#include "OccupancyCorpus.h"
+#include "Position.h"
 
-constexpr MagicEntry RookMagics[64] = {
-    {0x0080064000201081, 52, 4096},
-    {0x0040021001406000, 53, 2048},
-    {0x2080200070001880, 53, 2048},
-    {0x8100100100542088, 53, 2048},
-    {0x8e00042008120110, 53, 2048},
-    {0x4b00082400021100, 53, 2048},
-    {0x02000200040800b1, 53, 2048},
-    {0x0500028608402100, 52, 4096},
-    {0x9800800299214000, 53, 2048},
-    {0x0402002200810050, 54, 1024},
-    {0x0005001045002001, 54, 1024},
-    {0x0004801800d00280, 54, 1024},
-    {0x002900080101504c, 54, 1024},
-    {0x100d000c00880300, 54, 1024},
-    {0x2023808001003a00, 54, 1024},
-    {0x0101000182224100, 53, 2048},
-    {0x0004808000214000, 53, 2048},
-    {0x0011020049220080, 54, 1024},
-    {0x6288220040108203, 54, 1024},
-    {0x0222818008025002, 54, 1024},
-    {0x4004008080040800, 54, 1024},
-    {0x0500808012000400, 54, 1024},
-    {0x4012050100020004, 54, 1024},
-    {0x00000a0001840445, 53, 2048},
-    {0x4200800180284002, 53, 2048},
-    {0x001080a100400500, 54, 1024},
-    {0x0402500480200480, 54, 1024},
-    {0x2100100280080081, 54, 1024},
-    {0x0048010100110c08, 54, 1024},
-    {0x6000040080800200, 54, 1024},
-    {0x0226088400010210, 54, 1024},
-    {0x0018802680014100, 53, 2048},
-    {0x3000804000801024, 53, 2048},
-    {0x8110022001404008, 54, 1024},
-    {0x0800500080806000, 54, 1024},
-    {0x0880081042002200, 54, 1024},
-    {0xa800850091000800, 54, 1024},
-    {0x0101120080800400, 54, 1024},
-    {0x0000100804000122, 54, 1024},
-    {0x0004004286000c01, 53, 2048},
-    {0x0028400280228000, 53, 2048},
-    {0x0300c00081010020, 54, 1024},
-    {0x4020001000858020, 54, 1024},
-    {0x1002000810420020, 54, 1024},
-    {0x03820020180e0010, 54, 1024},
-    {0x0404040002008080, 54, 1024},
-    {0x3000aa1810040015, 54, 1024},
-    {0x4100010064920004, 53, 2048},
-    {0x6100204008801180, 53, 2048},
-    {0x010c2010004000c0, 54, 1024},
-    {0x8040402003001900, 54, 1024},
-    {0x0302001008224200, 54, 1024},
-    {0x4201000800308700, 54, 1024},
-    {0x0010800400020080, 54, 1024},
-    {0x2004500208031400, 54, 1024},
-    {0x0000800100005280, 53, 2048},
-    {0x00a02202450080b2, 52, 4096},
-    {0x808a220700401282, 53, 2048},
-    {0x2200200040090011, 53, 2048},
-    {0x2201000409201001, 53, 2048},
-    {0x1002010c08102042, 53, 2048},
-    {0x1d01000804000201, 53, 2048},
-    {0x01000802011000cc, 53, 2048},
-    {0x800081002088c402, 52, 4096}
-};
-
-constexpr MagicEntry BishopMagics[64] = {
-    {0x4040082704028010, 58, 64},
-    {0x000218c813004087, 59, 32},
-    {0x40849c0082004061, 59, 32},
-    {0xd012408102000840, 59, 32},
-    {0x00820a1000000000, 59, 32},
-    {0x0201092031000000, 59, 32},
-    {0x4002021082090403, 59, 32},
-    {0x0001004804040a41, 58, 64},
-    {0x000a292208520402, 59, 32},
-    {0x008014051c250e03, 59, 32},
-    {0x00501c0802014800, 59, 32},
-    {0x830104104a002002, 59, 32},
-    {0x0100908820201030, 59, 32},
-    {0x00c0044108400214, 59, 32},
-    {0x10007400a208600d, 59, 32},
-    {0x0000012101105001, 59, 32},
-    {0x0204082254840802, 59, 32},
-    {0x1004003004088420, 59, 32},
-    {0x0461120802006200, 57, 128},
-    {0x0104830802004100, 57, 128},
-    {0x2404028480a00000, 57, 128},
-    {0x4402000088040220, 57, 128},
-    {0x0082000103092189, 59, 32},
-    {0x00820c0041442c00, 59, 32},
-    {0x001018a4414a0400, 59, 32},
-    {0x0002060650040800, 59, 32},
-    {0xc0a8880010004550, 57, 128},
-    {0x4008080042620020, 55, 512},
-    {0x3201001081004001, 55, 512},
-    {0x004040806510100c, 57, 128},
-    {0x6048028201040101, 59, 32},
-    {0x1000408382060100, 59, 32},
-    {0x0011201005220400, 59, 32},
-    {0x090082100c200404, 59, 32},
-    {0x3020402800100d40, 57, 128},
-    {0x0082008400020120, 55, 512},
-    {0x00040100700c00c0, 55, 512},
-    {0x8210204080011004, 57, 128},
-    {0x0f07020600041100, 59, 32},
-    {0x0003040020408210, 59, 32},
-    {0xea0c023842002c10, 59, 32},
-    {0x0494012410014a01, 59, 32},
-    {0x2017004022003004, 57, 128},
-    {0x0002401414000800, 57, 128},
-    {0x4404400091000200, 57, 128},
-    {0x0624008401008810, 57, 128},
-    {0x0d0210060a000280, 59, 32},
-    {0x0104440042000040, 59, 32},
-    {0x0002080212d08000, 59, 32},
-    {0x0001410828220024, 59, 32},
-    {0x000000c200d01c20, 59, 32},
-    {0x00000000840c2000, 59, 32},
-    {0x000264080b040040, 59, 32},
-    {0x0018604431020470, 59, 32},
-    {0x0140022881010414, 59, 32},
-    {0x508810118a004981, 59, 32},
-    {0x8400841101012012, 58, 64},
-    {0x2020008205b00400, 59, 32},
-    {0xc010071042080400, 59, 32},
-    {0x00044080649c0400, 59, 32},
-    {0x0090502051120202, 59, 32},
-    {0x2002002002060a00, 59, 32},
-    {0xf010905050008284, 59, 32},
-    {0x00848804b8018100, 58, 64}
+using namespace std;
+using namespace magicbb;
 
+// Bishop magics for a 10x8 board (128-bit occupancy), found with main --bishop --board 10x8
+constexpr MagicEntry Bishop10x8Magics[80] = {
+    {0x44440020201062a1, 58, 64},
+    {0x60880038244a0018, 58, 64},
+    {0x0012100d08002090, 57, 128},
+    {0x4101005008101812, 57, 128},
+    {0x000180200900832c, 57, 128},
+    {0x0000800809080000, 57, 128},
+    {0x0090200e40280710, 57, 128},
+    {0x1181090108020404, 57, 128},
+    {0x0800501009808092, 58, 64},
+    {0x600a1c04440a2021, 58, 64},
+    {0x01008c0024120900, 59, 32},
+    {0x0902034820158044, 59, 32},
+    {0x0004008001040120, 58, 64},
+    {0x0024408071410088, 57, 128},
+    {0x0404081002408004, 57, 128},
+    {0x2260122002140800, 57, 128},
+    {0x2800040602810802, 57, 128},
+    {0x0921000600840082, 58, 64},
+    {0x2500208441848101, 59, 32},
+    {0x0228482821810010, 59, 32},
+    {0x4c30000441029280, 59, 32},
+    {0x0001012020100021, 59, 32},
+    {0x0041000060042008, 57, 128},
+    {0x0005000001010080, 56, 256},
+    {0xc02284002a020020, 55, 512},
+    {0x00141008a010c00a, 55, 512},
+    {0x0800100002094202, 56, 256},
+    {0x0448880100401101, 57, 128},
+    {0x02401000c8a10500, 59, 32},
+    {0x040010002a8a1080, 59, 32},
+    {0x0805090800200081, 59, 32},
+    {0x000402c0400818c0, 59, 32},
+    {0x2981023010020202, 57, 128},
+    {0x8082020800280080, 55, 512},
+    {0x0040800800400c01, 54, 1024},
+    {0x5404042001001041, 54, 1024},
+    {0x0002806800071005, 55, 512},
+    {0x1209408480024008, 57, 128},
+    {0x2800200a22001080, 59, 32},
+    {0x3000200814002004, 59, 32},
+    {0x80a44c8505c14601, 59, 32},
+    {0x2423001110a20205, 59, 32},
+    {0x21a1000420480042, 57, 128},
+    {0x060600b004008404, 55, 512},
+    {0x0050002802000009, 54, 1024},
+    {0x1a0400640100630b, 54, 1024},
+    {0x8080408104000a11, 55, 512},
+    {0x000020210200a010, 57, 128},
+    {0x0020101004080010, 59, 32},
+    {0x0018400502002008, 59, 32},
+    {0x041608440808c002, 59, 32},
+    {0x2013001015584113, 59, 32},
+    {0x0001042004230125, 57, 128},
+    {0x0074040102080003, 56, 256},
+    {0x0400844012020101, 55, 512},
+    {0x8081102060084004, 55, 512},
+    {0x010180045004204a, 56, 256},
+    {0x0500288004000800, 57, 128},
+    {0x8702081008802084, 59, 32},
+    {0x40009089040c1001, 59, 32},
+    {0x0430108148080800, 59, 32},
+    {0x8004405002120822, 59, 32},
+    {0x0044605450004500, 58, 64},
+    {0xc000101010481080, 57, 128},
+    {0x845b130040120080, 57, 128},
+    {0x014c1040800c0840, 57, 128},
+    {0x0104010001108108, 57, 128},
+    {0x0056050030022012, 58, 64},
+    {0x3f08860808018040, 59, 32},
+    {0x6001806009085420, 59, 32},
+    {0x0080060488080104, 58, 64},
+    {0x0020102202140022, 58, 64},
+    {0x0108922040460141, 57, 128},
+    {0x4401000020811101, 57, 128},
+    {0x0700000408100409, 57, 128},
+    {0x08040000600226a0, 57, 128},
+    {0x8080202008100008, 57, 128},
+    {0x1000610202010100, 57, 128},
+    {0x2100410046120020, 58, 64},
+    {0x0001284848064270, 58, 64}
 };
 
-// Attack tables
-array<vector<Bitboard>, 64> RookAttackTable;
-array<vector<Bitboard>, 64> BishopAttackTable;
-
-// Masks for rook and bishop
-array<Bitboard, 64> RookMasks;
-array<Bitboard, 64> BishopMasks;
-
-// Utility functions
-template<class T> inline T BIT(const T &x) {
-    return (T(1) << x);
-}
-
-template<class T> inline bool IsBitSet(const T &object, int bitIndex) {
-    return (object >> bitIndex) & 1;
-}
-
-template<class T> inline void SetBit(T &object, int bitIndex) {
-    object |= BIT<T>(bitIndex);
-}
-
-// Count bits in a bitboard (popcount)
-int CountBits(Bitboard b) {
-    return bitset<64>(b).count();
-}
-
-// Print a bitboard in a chessboard format
-void PrintBitboard(Bitboard bb, const string& title = "") {
-    if (!title.empty()) {
-        cout << title << ":\n";
-    }
-    
-    for (int row = 7; row >= 0; row--) {
-        cout << row + 1 << " ";
-        for (int col = 0; col < 8; col++) {
-            int square = row * 8 + col;
-            cout << (IsBitSet(bb, square) ? "x " : ". ");
-        }
-        cout << "\n";
-    }
-    cout << "  a b c d e f g h\n\n";
-}
-
-// Generate rook moves mask (excluding edges)
-Bitboard GenerateRookMovesMask(int sqr) {
-    Bitboard output = 0;
-    int row = sqr / 8, col = sqr % 8;
-    
-    // Up (excluding edge)
-    for (int r = row + 1; r < 7; r++) 
-        SetBit(output, r * 8 + col);
-    
-    // Down (excluding edge)
-    for (int r = row - 1; r > 0; r--) 
-        SetBit(output, r * 8 + col);
-    
-    // Right (excluding edge)
-    for (int c = col + 1; c < 7; c++) 
-        SetBit(output, row * 8 + c);
-    
-    // Left (excluding edge)
-    for (int c = col - 1; c > 0; c--) 
-        SetBit(output, row * 8 + c);
-    
-    return output;
-}
-
-Bitboard GenerateBishopMovesMask(int sqr) {
-    Bitboard output = 0;
-    int row = sqr / 8, col = sqr % 8;
-    
-    // Down-Right (excluding edges)
-    for (int r = row + 1, c = col + 1; r < 7 && c < 7; r++, c++) 
-        SetBit(output, r * 8 + c);
-    
-    // Down-Left (excluding edges)
-    for (int r = row + 1, c = col - 1; r < 7 && c > 0; r++, c--) 
-        SetBit(output, r * 8 + c);
-    
-    // Up-Right (excluding edges)
-    for (int r = row - 1, c = col + 1; r > 0 && c < 7; r--, c++) 
-        SetBit(output, r * 8 + c);
-    
-    // Up-Left (excluding edges)
-    for (int r = row - 1, c = col - 1; r > 0 && c > 0; r--, c--) 
-        SetBit(output, r * 8 + c);
-    
-    return output;
-}
-
-// Generate actual rook attacks considering blockers
-Bitboard GenerateRookAttacks(int sq, Bitboard blockers) {
-    Bitboard attacks = 0;
-    int row = sq / 8, col = sq % 8;
-    
-    // Up
-    for (int r = row + 1; r < 8; r++) {
-        int target = r * 8 + col;
-        SetBit(attacks, target);
-        if (IsBitSet(blockers, target)) break;
-    }
-    // Down
-    for (int r = row - 1; r >= 0; r--) {
-        int target = r * 8 + col;
-        SetBit(attacks, target);
-        if (IsBitSet(blockers, target)) break;
-    }
-    // Right
-    for (int c = col + 1; c < 8; c++) {
-        int target = row * 8 + c;
-        SetBit(attacks, target);
-        if (IsBitSet(blockers, target)) break;
-    }
-    // Left
-    for (int c = col - 1; c >= 0; c--) {
-        int target = row * 8 + c;
-        SetBit(attacks, target);
-        if (IsBitSet(blockers, target)) break;
-    }
-    
-    return attacks;
-}
-
-// Generate actual bishop attacks considering blockers
-Bitboard GenerateBishopAttacks(int sq, Bitboard blockers) {
-    Bitboard attacks = 0;
-    int row = sq / 8, col = sq % 8;
-    
-    // Down-right
-    for (int r = row + 1, c = col + 1; r < 8 && c < 8; r++, c++) {
-        int target = r * 8 + c;
-        SetBit(attacks, target);
-        if (IsBitSet(blockers, target)) break;
-    }
-    // Down-left
-    for (int r = row + 1, c = col - 1; r < 8 && c >= 0; r++, c--) {
-        int target = r * 8 + c;
-        SetBit(attacks, target);
-        if (IsBitSet(blockers, target)) break;
-    }
-    // Up-right
-    for (int r = row - 1, c = col + 1; r >= 0 && c < 8; r--, c++) {
-        int target = r * 8 + c;
-        SetBit(attacks, target);
-        if (IsBitSet(blockers, target)) break;
-    }
-    // Up-left
-    for (int r = row - 1, c = col - 1; r >= 0 && c >= 0; r--, c--) {
-        int target = r * 8 + c;
-        SetBit(attacks, target);
-        if (IsBitSet(blockers, target)) break;
-    }
-    
-    return attacks;
-}
-
-// Initialize all masks
-void InitializeMasks() {
-    for (int sq = 0; sq < 64; sq++) {
-        RookMasks[sq] = GenerateRookMovesMask(sq);
-        BishopMasks[sq] = GenerateBishopMovesMask(sq);
-    }
-}
-
-// Initialize attack tables
-void InitializeAttackTables() {
-    // Initialize rook attack tables
-    for (int sq = 0; sq < 64; sq++) {
-        if (RookMagics[sq].shift == 64) {
-            // Skip if magic not found for this square
-            continue;
-        }
-        
-        Bitboard mask = RookMasks[sq];
-        int tableSize = RookMagics[sq].tableSize;
-        RookAttackTable[sq].resize(tableSize, 0);
-        
-        // Generate all possible blocker configurations using Carry-Rippler method
-        Bitboard blockers = 0;
-        do {
-            // Calculate index using magic multiplication
-            int index = (blockers * RookMagics[sq].magic) >> RookMagics[sq].shift;
-            
-            // Generate and store attacks for this blocker configuration
-            if (index >= 0 && index < tableSize) {
-                RookAttackTable[sq][index] = GenerateRookAttacks(sq, blockers);
-            }
-            
-            // Get next subset of blockers
-            blockers = (blockers - mask) & mask;
-        } while (blockers != 0);
-    }
-    
-    // Initialize bishop attack tables
-    for (int sq = 0; sq < 64; sq++) {
-        if (BishopMagics[sq].shift == 64) {
-            // Skip if magic not found for this square
-            continue;
-        }
-        
-        Bitboard mask = BishopMasks[sq];
-        int tableSize = BishopMagics[sq].tableSize;
-        BishopAttackTable[sq].resize(tableSize, 0);
-        
-        // Generate all possible blocker configurations using Carry-Rippler method
-        Bitboard blockers = 0;
-        do {
-            // Calculate index using magic multiplication
-            int index = (blockers * BishopMagics[sq].magic) >> BishopMagics[sq].shift;
-            
-            // Generate and store attacks for this blocker configuration
-            if (index >= 0 && index < tableSize) {
-                BishopAttackTable[sq][index] = GenerateBishopAttacks(sq, blockers);
-            }
-            
-            // Get next subset of blockers
-            blockers = (blockers - mask) & mask;
-        } while (blockers != 0);
-    }
-}
-
-// Get rook attacks using magic bitboards
-Bitboard GetRookAttacks(int sq, Bitboard occupancy) {
-    // Get relevant blockers (only those on the mask)
-    Bitboard blockers = occupancy & RookMasks[sq];
-    
-    // Calculate index using magic multiplication
-    int index = (blockers * RookMagics[sq].magic) >> RookMagics[sq].shift;
-    
-    // Return precomputed attacks with bounds checking
-    if (index >= 0 && index < static_cast<int>(RookAttackTable[sq].size())) {
-        return RookAttackTable[sq][index];
-    }
-    
-    // Fallback if index is out of bounds
-    return GenerateRookAttacks(sq, occupancy);
-}
-
-// Get bishop attacks using magic bitboards
-Bitboard GetBishopAttacks(int sq, Bitboard occupancy) {
-    // Get relevant blockers (only those on the mask)
-    Bitboard blockers = occupancy & BishopMasks[sq];
-    
-    // Calculate index using magic multiplication
-    int index = (blockers * BishopMagics[sq].magic) >> BishopMagics[sq].shift;
-    
-    // Return precomputed attacks with bounds checking
-    if (index >= 0 && index < static_cast<int>(BishopAttackTable[sq].size())) {
-        return BishopAttackTable[sq][index];
-    }
-    
-    // Fallback if index is out of bounds
-    return GenerateBishopAttacks(sq, occupancy);
-}
-
-// Get queen attacks (combination of rook and bishop)
-Bitboard GetQueenAttacks(int sq, Bitboard occupancy) {
-    return GetRookAttacks(sq, occupancy) | GetBishopAttacks(sq, occupancy);
-}
-
 // Validate magic numbers
 bool ValidateMagic(int sq, const MagicEntry& magic, bool isBishop) {
     Bitboard mask = isBishop ? BishopMasks[sq] : RookMasks[sq];
@@ -641,6 +334,610 @@ void TestSpecificProblemSquares() {
     
     cout << "All problem square tests passed!" << endl;
 }
+
+void TestCompactAttackTables(int iterations = 10000) {
+    cout << "Testing compact attack tables (" << iterations << " iterations)..." << endl;
+    
+    std::mt19937_64 rng(std::chrono::system_clock::now().time_since_epoch().count());
+    std::uniform_int_distribution<uint64_t> dist(0, UINT64_MAX);
+    
+    for (int i = 0; i < iterations; i++) {
+        Bitboard occupancy = dist(rng);
+        for (int sq = 0; sq < 64; sq++) {
+            Bitboard rookFlat = GetRookAttacks(sq, occupancy);
+            assert(GetRookAttacksCompact<uint8_t>(sq, occupancy) == rookFlat);
+            assert(GetRookAttacksCompact<uint16_t>(sq, occupancy) == rookFlat);
+            
+            Bitboard bishopFlat = GetBishopAttacks(sq, occupancy);
+            assert(GetBishopAttacksCompact<uint8_t>(sq, occupancy) == bishopFlat);
+            assert(GetBishopAttacksCompact<uint16_t>(sq, occupancy) == bishopFlat);
+        }
+    }
+    
+    cout << "All compact attack table tests passed!" << endl;
+}
+
+// Compare the compile-time specialised lookup of every square against the runtime one
+template<int... Squares> void CheckCompileTimeLookups(Bitboard occupancy, integer_sequence<int, Squares...>) {
+    ((assert((attacks<Piece::Rook, Square(Squares)>(occupancy) == GetRookAttacks(Squares, occupancy))),
+      assert((attacks<Piece::Bishop, Square(Squares)>(occupancy) == GetBishopAttacks(Squares, occupancy))),
+      assert((attacks<Piece::Queen, Square(Squares)>(occupancy) == GetQueenAttacks(Squares, occupancy)))), ...);
+}
+
+void TestLibraryLookups(int iterations = 10000) {
+    cout << "Testing library lookups (" << iterations << " iterations)..." << endl;
+    
+    std::mt19937_64 rng(std::chrono::system_clock::now().time_since_epoch().count());
+    std::uniform_int_distribution<uint64_t> dist(0, UINT64_MAX);
+    
+    for (int i = 0; i < iterations; i++) {
+        Bitboard occupancy = dist(rng);
+        for (int sq = 0; sq < 64; sq++) {
+            assert(attacks<Piece::Rook>(sq, occupancy) == GenerateRookAttacks(sq, occupancy));
+            assert(attacks<Piece::Bishop>(sq, occupancy) == GenerateBishopAttacks(sq, occupancy));
+            assert(attacks<Piece::Queen>(sq, occupancy) == GetQueenAttacks(sq, occupancy));
+        }
+        CheckCompileTimeLookups(occupancy, make_integer_sequence<int, 64>());
+    }
+    
+    // Spot check with named squares
+    assert(CountBits(attacks<Piece::Rook, A1>(0)) == 14);
+    assert(CountBits(attacks<Piece::Bishop, D4>(0)) == 13);
+    
+    cout << "All library lookup tests passed!" << endl;
+}
+
+bool SameMobility(const MobilityEntry &entry, Bitboard attackSet) {
+    if (entry.total != CountBits(attackSet)) return false;
+    for (int i = 0; i < MobilityRegionCount; i++)
+        if (entry.regions[i] != CountBits(attackSet & MobilityRegions[i])) return false;
+    return true;
+}
+
+void TestMobilityTables(int iterations = 10000) {
+    cout << "Testing mobility tables (" << iterations << " iterations)..." << endl;
+    
+    std::mt19937_64 rng(std::chrono::system_clock::now().time_since_epoch().count());
+    std::uniform_int_distribution<uint64_t> dist(0, UINT64_MAX);
+    
+    // Default regions, then custom ones, which must rebuild the table in place
+    const std::array<Bitboard, MobilityRegionCount> custom = {
+        0x8100000000000081ULL, 0x0000001818000000ULL, 0xFF000000000000FFULL
+    };
+    for (const auto &regions : {DefaultMobilityRegions, custom}) {
+        SetMobilityRegions(regions);
+        for (int i = 0; i < iterations; i++) {
+            Bitboard occupancy = dist(rng) & dist(rng);
+            for (int sq = 0; sq < 64; sq++) {
+                assert(SameMobility(mobility<Piece::Rook>(sq, occupancy), GenerateRookAttacks(sq, occupancy)));
+                assert(SameMobility(mobility<Piece::Bishop>(sq, occupancy), GenerateBishopAttacks(sq, occupancy)));
+                assert(SameMobility(mobility<Piece::Queen>(sq, occupancy), GetQueenAttacks(sq, occupancy)));
+                assert(SameMobility(GetRookMobility(sq, occupancy), GetRookAttacks(sq, occupancy)));
+                assert(SameMobility(GetBishopMobility(sq, occupancy), GetBishopAttacks(sq, occupancy)));
+            }
+        }
+        assert((mobility<Piece::Rook, A1>(0).total == 14));
+        assert((SameMobility(mobility<Piece::Queen, E4>(0), GetQueenAttacks(E4, 0))));
+    }
+    SetMobilityRegions(DefaultMobilityRegions);
+    
+    cout << "All mobility table tests passed!" << endl;
+}
+
+// Walk each ray from sq; after the first occupied square, keep going only if it is in blockers
+Bitboard ReferenceXrayAttacks(int sq, Bitboard occupancy, Bitboard blockers, bool isBishop) {
+    static const int rookDirections[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    static const int bishopDirections[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+    Bitboard result = 0;
+    for (auto &d : isBishop ? bishopDirections : rookDirections) {
+        bool passed = false;
+        for (int r = sq / 8 + d[0], f = sq % 8 + d[1]; r >= 0 && r < 8 && f >= 0 && f < 8; r += d[0], f += d[1]) {
+            Bitboard bit = BIT<Bitboard>(r * 8 + f);
+            if (passed) result |= bit;
+            if (!(occupancy & bit)) continue;
+            if (passed || !(blockers & bit)) break;
+            passed = true;
+        }
+    }
+    return result;
+}
+
+void TestXrayAndLineTables(int iterations = 10000) {
+    cout << "Testing x-ray lookups and between/line tables (" << iterations << " iterations)..." << endl;
+    
+    std::mt19937_64 rng(std::chrono::system_clock::now().time_since_epoch().count());
+    std::uniform_int_distribution<uint64_t> dist(0, UINT64_MAX);
+    
+    for (int i = 0; i < iterations; i++) {
+        Bitboard occupancy = dist(rng) & dist(rng);
+        Bitboard blockers = occupancy & dist(rng);
+        for (int sq = 0; sq < 64; sq++) {
+            Bitboard others = occupancy & ~BIT<Bitboard>(sq);
+            assert(GetRookXrayAttacks(sq, others, blockers) == ReferenceXrayAttacks(sq, others, blockers, false));
+            assert(GetBishopXrayAttacks(sq, others, blockers) == ReferenceXrayAttacks(sq, others, blockers, true));
+        }
+    }
+    
+    for (int a = 0; a < 64; a++) {
+        for (int b = 0; b < 64; b++) {
+            bool aligned = a != b && (a / 8 == b / 8 || a % 8 == b % 8 || a / 8 - a % 8 == b / 8 - b % 8 ||
+                                      a / 8 + a % 8 == b / 8 + b % 8);
+            if (!aligned) {
+                assert(Between[a][b] == 0 && Line[a][b] == 0);
+                continue;
+            }
+            assert(Between[a][b] == Between[b][a] && Line[a][b] == Line[b][a]);
+            // Along the line, sliders on a and b blocked by each other both see only the gap
+            Bitboard reach = Line[a][b] & GetQueenAttacks(a, BIT<Bitboard>(b)) & GetQueenAttacks(b, BIT<Bitboard>(a));
+            assert(Between[a][b] == reach);
+            assert(CountBits(Between[a][b]) == max(abs(a / 8 - b / 8), abs(a % 8 - b % 8)) - 1);
+            assert((Line[a][b] & BIT<Bitboard>(a)) && (Line[a][b] & BIT<Bitboard>(b)));
+            assert((Between[a][b] & ~Line[a][b]) == 0);
+            for (int c = 0; c < 64; c++)
+                if (Line[a][b] & BIT<Bitboard>(c)) assert(c == a || Line[a][c] == Line[a][b]);
+        }
+    }
+    
+    // Between along a rank and a diagonal, line along a file
+    assert(Between[A1][D1] == (BIT<Bitboard>(B1) | BIT<Bitboard>(C1)));
+    assert(Between[C1][F4] == (BIT<Bitboard>(D2) | BIT<Bitboard>(E3)));
+    assert(Line[E2][E7] == 0x1010101010101010ULL);
+    
+    cout << "All x-ray and line table tests passed!" << endl;
+}
+
+void TestVariantBoardLookups(int iterations = 10000) {
+    cout << "Testing geometry-generic masks and 10x8 lookups (" << iterations << " iterations)..." << endl;
+    
+    std::mt19937_64 rng(std::chrono::system_clock::now().time_since_epoch().count());
+    std::uniform_int_distribution<uint64_t> dist(0, UINT64_MAX);
+    
+    // The generic generators instantiated for 8x8 must match the chess ones
+    for (int sq = 0; sq < 64; sq++) {
+        assert(GenerateRookMask<Chess8x8>(sq) == RookMasks[sq]);
+        assert(GenerateBishopMask<Chess8x8>(sq) == BishopMasks[sq]);
+    }
+    for (int i = 0; i < iterations / 10; i++) {
+        Bitboard occupancy = dist(rng);
+        for (int sq = 0; sq < 64; sq++) {
+            assert(GenerateRookAttacksOn<Chess8x8>(sq, occupancy) == GenerateRookAttacks(sq, occupancy));
+            assert(GenerateBishopAttacksOn<Chess8x8>(sq, occupancy) == GenerateBishopAttacks(sq, occupancy));
+        }
+    }
+    
+    // 128-bit board: magic lookups must match the loop-based generator
+    VariantMagicTable<Board10x8> bishops;
+    bishops.Build(true, Bishop10x8Magics);
+    const uint128 boardMask = (uint128(1) << Board10x8::Squares) - 1;
+    for (int i = 0; i < iterations; i++) {
+        uint128 occupancy = ((uint128(dist(rng)) << 64) | dist(rng)) & boardMask;
+        for (int sq = 0; sq < Board10x8::Squares; sq++)
+            assert(bishops.Lookup(sq, occupancy) == GenerateBishopAttacksOn<Board10x8>(sq, occupancy));
+    }
+    
+    cout << "All variant board tests passed!" << endl;
+}
+
+void TestConstructiveSearch() {
+    cout << "Testing constructive magic search..." << endl;
+    
+    for (int sq : {0, 1, 27, 36, 63}) {
+        vector<Bitboard> blockers, references;
+        FillBlockerSubsets<Chess8x8>(BishopMasks[sq], blockers);
+        for (Bitboard b : blockers)
+            references.push_back(GenerateBishopAttacks(sq, b));
+        int bits = CountBits(BishopMasks[sq]);
+        
+        // Full-size index: a magic must turn up and pass the usual collision check
+        atomic<int64_t> budget(10000000);
+        atomic<bool> stop(false);
+        ConstructiveMagicSearch search(blockers.data(), references.data(), blockers.size(), bits, 7);
+        assert(search.SearchPrefix(0, 0, budget, stop) == ConstructiveMagicSearch::Found);
+        MagicEntry entry = {search.Magic(), 64 - bits, 1 << bits};
+        assert(ValidateMagic(sq, entry, true));
+        assert(CountBits(search.Magic()) <= 7);
+    }
+    
+    // One bit short on d1: no magic with at most 6 set bits exists, and the
+    // whole tree must be explored within the budget to prove it
+    vector<Bitboard> blockers, references;
+    FillBlockerSubsets<Chess8x8>(BishopMasks[3], blockers);
+    for (Bitboard b : blockers)
+        references.push_back(GenerateBishopAttacks(3, b));
+    atomic<int64_t> budget(10000000);
+    atomic<bool> stop(false);
+    ConstructiveMagicSearch search(blockers.data(), references.data(), blockers.size(), 4, 6);
+    assert(search.SearchPrefix(0, 0, budget, stop) == ConstructiveMagicSearch::Exhausted);
+    
+    cout << "All constructive search tests passed!" << endl;
+}
+
+// Scratch files go to the system temp directory, not the working directory
+string TempPath(const string &name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+void TestMagicDatabase() {
+    cout << "Testing magic database..." << endl;
+    
+    // Bishop b1 has 6 distinct attack sets over 32 subsets; this 4-bit magic (one bit
+    // below the mask) must share slots constructively, and the annotation has to
+    // account for every subset
+    const uint64_t shrunkMagic = 0x894a1705f31bf56eull;
+    vector<Bitboard> blockers;
+    FillBlockerSubsets<Chess8x8>(BishopMasks[1], blockers);
+    Bitboard slots[16] = {};
+    for (Bitboard b : blockers) {
+        Bitboard &slot = slots[(b * shrunkMagic) >> 60];
+        assert(slot == 0 || slot == GenerateBishopAttacks(1, b));
+        slot = GenerateBishopAttacks(1, b);
+    }
+    MagicRecord shrunk = AnnotateMagic(true, 1, shrunkMagic, 60, blockers.data(), blockers.size());
+    size_t used = shrunk.TableSize() - shrunk.EmptyCount();
+    assert(used >= 6 && used + shrunk.constructiveCollisions == blockers.size());
+    assert(shrunk.maxIndex < shrunk.TableSize() && !shrunk.IsEmpty(shrunk.maxIndex));
+    for (size_t slot = shrunk.maxIndex + 1; slot < shrunk.TableSize(); slot++)
+        assert(shrunk.IsEmpty(slot));
+    
+    // Full-size library magics: no collisions, every slot used
+    MagicDatabase database(8, 8, 3);
+    for (int sq = 0; sq < 64; sq++) {
+        vector<Bitboard> subsets;
+        FillBlockerSubsets<Chess8x8>(RookMasks[sq], subsets);
+        MagicRecord record = AnnotateMagic(false, sq, RookMagics[sq].magic, RookMagics[sq].shift,
+                                           subsets.data(), subsets.size());
+        assert(record.constructiveCollisions == 0 && record.EmptyCount() == 0);
+        assert(record.maxIndex == record.TableSize() - 1);
+        assert(database.Add(record));
+        assert(!database.Add(record));   // duplicates are dropped
+    }
+    
+    // b1's mask has no a1 blocker, so flipping the top magic bit moves no subset:
+    // a different magic with the same table is a duplicate too
+    MagicRecord flipped = AnnotateMagic(true, 1, shrunkMagic ^ (uint64_t(1) << 63), 60, blockers.data(), blockers.size());
+    assert(flipped.magic != shrunk.magic && flipped.mappingHash == shrunk.mappingHash);
+    MagicDatabase twins(8, 8, 3);
+    assert(twins.Add(flipped) && !twins.Add(shrunk));
+    
+    // A full pool keeps its best records, best first
+    database.Add(shrunk);
+    for (int i = 0; i < 4; i++) {
+        MagicRecord worse = shrunk;
+        worse.magic = ~uint64_t(0) - i;
+        worse.mappingHash = i;
+        worse.maxIndex = 15;
+        worse.emptySlots.assign(1, 0);
+        database.Add(worse);
+    }
+    const vector<MagicRecord> &pool = database.Query(true, 1, 60);
+    assert(pool.size() == 3 && pool[0].magic == shrunk.magic);
+    for (size_t i = 1; i < pool.size(); i++)
+        assert(!pool[i].BetterThan(pool[i - 1]));
+    assert(database.Query(true, 1, 59).empty() && database.Shifts(true, 1) == vector<int>{60});
+    
+    // Round trip through the file; a different geometry refuses to load it
+    const string path = TempPath("MoveGenerationTests.magicdb");
+    assert(database.Save(path));
+    MagicDatabase loaded(8, 8, 3);
+    assert(loaded.Load(path) && loaded.RecordCount() == database.RecordCount());
+    for (int sq = 0; sq < 64; sq++) {
+        const MagicRecord &a = database.Query(false, sq, RookMagics[sq].shift)[0];
+        const MagicRecord &b = loaded.Query(false, sq, RookMagics[sq].shift)[0];
+        assert(a.magic == b.magic && a.mappingHash == b.mappingHash && a.maxIndex == b.maxIndex && a.emptySlots == b.emptySlots);
+    }
+    assert(loaded.Query(true, 1, 60)[0].constructiveCollisions == shrunk.constructiveCollisions);
+    MagicDatabase wrongBoard(10, 8, 3);
+    assert(!wrongBoard.Load(path));
+    // A record whose square is off the board is malformed (first record's square byte)
+    FILE *file = fopen(path.c_str(), "r+b");
+    assert(file);
+    fseek(file, 16 + 8 + 8 + 1, SEEK_SET);
+    fputc(64, file);
+    fclose(file);
+    MagicDatabase offBoard(8, 8, 3);
+    assert(!offBoard.Load(path));
+    std::remove(path.c_str());
+    
+    cout << "All magic database tests passed!" << endl;
+}
+
+void TestLegalMoveGeneration(uint64_t maxNodes = 200000) {
+    cout << "Testing legal move generation with perft (up to " << maxNodes << " nodes per position)..." << endl;
+    
+    // FEN parsing round-trips, and malformed FENs are rejected
+    Position pos;
+    for (const PerftCase &test : StandardPerftPositions) {
+        assert(pos.SetFen(test.fen));
+        assert(pos.Fen() == test.fen);
+    }
+    assert(!pos.SetFen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP w KQkq - 0 1"));
+    assert(!pos.SetFen("rnbqkbnr/pppppppp/9/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"));
+    assert(!pos.SetFen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQ1BNR w KQkq - 0 1"));
+    assert(!pos.SetFen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x KQkq - 0 1"));
+    assert(!pos.SetFen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq e3 0 1"));
+    assert(!pos.SetFen("rnbqkbnP/pppppppp/8/8/8/8/PPPPPPP1/RNBQKBNR w KQkq - 0 1"));
+    // En passant needs an empty target with the pushed pawn behind it, and the side
+    // not to move can't be in check (two kings each are rejected too)
+    assert(!pos.SetFen("4k3/8/8/3P4/8/8/8/4K3 w - e6 0 1"));
+    assert(!pos.SetFen("4k3/8/4p3/3Pp3/8/8/8/4K3 w - e6 0 1"));
+    assert(pos.SetFen("4k3/8/8/3Pp3/8/8/8/4K3 w - e6 0 1"));
+    assert(!pos.SetFen("4k3/8/8/8/8/8/8/4RK2 w - - 0 1"));
+    assert(pos.SetFen("4k3/8/8/8/8/8/8/4RK2 b - - 0 1") && pos.InCheck());
+    assert(!pos.SetFen("4k2k/8/8/8/8/8/8/4K3 w - - 0 1"));
+    
+    // Castling rights without the king or rook at home are dropped, not played
+    assert(pos.SetFen("4k3/8/8/8/8/8/8/4K3 w K - 0 1") && pos.castling == 0);
+    assert(pos.SetFen("r3k3/8/8/8/8/8/8/R3K2R w KQkq - 0 1") && pos.Fen() == "r3k3/8/8/8/8/8/8/R3K2R w KQq - 0 1");
+    pos.castling |= WhiteKingside;
+    pos.Remove(H1);
+    MoveList castles;
+    GenerateLegalMoves(pos, castles);
+    for (Move move : castles)
+        assert(MoveToUci(move) != "e1g1");
+    
+    for (const PerftCase &test : StandardPerftPositions) {
+        pos.SetFen(test.fen);
+        for (int depth = 1; depth <= int(test.nodes.size()) && test.nodes[depth - 1] <= maxNodes; depth++) {
+            uint64_t nodes = Perft(pos, depth);
+            if (nodes != test.nodes[depth - 1]) {
+                cerr << "Perft mismatch for " << test.name << " at depth " << depth
+                     << ": expected " << test.nodes[depth - 1] << ", got " << nodes << endl;
+                assert(false);
+            }
+        }
+    }
+    
+    // En passant that would expose the king along the rank is illegal
+    pos.SetFen("8/8/8/KPp4r/8/8/8/7k w - c6 0 1");
+    MoveList moves;
+    GenerateLegalMoves(pos, moves);
+    for (Move move : moves)
+        assert(MoveKindOf(move) != EnPassantMove);
+    
+    // Double check leaves only king moves
+    pos.SetFen("4k3/8/8/8/8/5n2/8/r3K2R w K - 0 1");
+    assert(pos.InCheck());
+    GenerateLegalMoves(pos, moves);
+    for (Move move : moves)
+        assert(MoveFrom(move) == E1);
+    
+    cout << "All legal move generation tests passed!" << endl;
+}
+
+void TestAttackMap(int games = 50) {
+    cout << "Testing incremental attack map (" << games << " random games per position)..." << endl;
+    
+    std::mt19937_64 rng(std::chrono::system_clock::now().time_since_epoch().count());
+    for (const PerftCase &test : StandardPerftPositions) {
+        for (int game = 0; game < games; game++) {
+            Position pos;
+            pos.SetFen(test.fen);
+            AttackMap map;
+            map.Compute(pos);
+            for (int ply = 0; ply < 200; ply++) {
+                MoveList moves;
+                GenerateLegalMoves(pos, moves);
+                if (moves.size() == 0) break;
+                Move move = moves[rng() % moves.size()];
+                Position next = pos.Play(move);
+                map.Update(pos, move, next);
+                
+                // Must match a full recomputation and the position's own attacker query
+                AttackMap full;
+                full.Compute(next);
+                assert(map == full);
+                for (int sq = 0; sq < 64; sq++)
+                    assert(map.AttackersTo(sq) == next.AttackersTo(sq, next.occupied));
+                assert(!(map.Attacks(next, next.sideToMove) & next.pieces[next.sideToMove ^ 1][King]));
+                pos = next;
+            }
+        }
+    }
+    
+    cout << "All attack map tests passed!" << endl;
+}
+
+void TestOccupancyCorpus(int games = 20) {
+    cout << "Testing EPD/FEN corpus reader..." << endl;
+    
+    // Write FENs and EPD lines of played-out positions, plus lines the reader must skip
+    const string path = TempPath("MoveGenerationTests.corpus.epd");
+    vector<Position> expected;
+    {
+        ofstream out(path);
+        out << "# comment line\n\n";
+        std::mt19937_64 rng(7);
+        for (int game = 0; game < games; game++) {
+            Position pos;
+            pos.SetFen(StartFen);
+            for (int ply = 0; ply < 120; ply++) {
+                expected.push_back(pos);
+                string fen = pos.Fen();
+                // Odd plies as EPD: four fields and an opcode instead of the move counters
+                if (ply % 2) out << fen.substr(0, fen.rfind(' ', fen.rfind(' ') - 1)) << " bm e4; id \"x\";\n";
+                else out << fen << "\r\n";
+                MoveList moves;
+                GenerateLegalMoves(pos, moves);
+                if (moves.size() == 0) break;
+                pos = pos.Play(moves[rng() % moves.size()]);
+            }
+        }
+        out << "rnbqkbnr/pppppppp/9/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1\n";
+        out << "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP w KQkq - 0 1\n";
+        out << "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNX w KQkq - 0 1";
+    }
+    
+    OccupancyCorpus corpus;
+    assert(corpus.Open(path));
+    size_t cursor = 0, count = 0;
+    CorpusBoard board;
+    while (corpus.Next(cursor, board)) {
+        assert(count < expected.size());
+        const Position &pos = expected[count++];
+        assert(board.occupancy == pos.occupied);
+        assert(board.rookSliders == (pos.pieces[White][Rook] | pos.pieces[Black][Rook] |
+                                     pos.pieces[White][Queen] | pos.pieces[Black][Queen]));
+        assert(board.bishopSliders == (pos.pieces[White][Bishop] | pos.pieces[Black][Bishop] |
+                                       pos.pieces[White][Queen] | pos.pieces[Black][Queen]));
+    }
+    assert(count == expected.size());
+    
+    size_t queries = 0;
+    assert(corpus.ForEachQuery([&](Piece, int, Bitboard) { queries++; }) == expected.size());
+    assert(queries > expected.size());
+    corpus.Close();
+    
+    // An empty file is an empty corpus; a missing one fails to open
+    ofstream(path, ios::trunc).close();
+    assert(corpus.Open(path) && corpus.Bytes() == 0);
+    cursor = 0;
+    assert(!corpus.Next(cursor, board));
+    corpus.Close();
+    std::remove(path.c_str());
+    assert(!corpus.Open(path));
+    
+    cout << "All corpus reader tests passed!" << endl;
+}
+
+// Every slider lookup of a real-game corpus against the reference generators
+void TestCorpusLookups(const OccupancyCorpus &corpus) {
+    cout << "Testing lookups on the corpus (" << corpus.Bytes() << " bytes)..." << endl;
+    size_t queries = 0;
+    size_t boards = corpus.ForEachQuery([&](Piece piece, int sq, Bitboard occupancy) {
+        if (piece == Piece::Rook) {
+            assert(GetRookAttacks(sq, occupancy) == GenerateRookAttacks(sq, occupancy));
+            assert(attacks<Piece::Rook>(sq, occupancy) == GenerateRookAttacks(sq, occupancy));
+            assert(GetRookAttacksCompact<uint8_t>(sq, occupancy) == GenerateRookAttacks(sq, occupancy));
+        } else {
+            assert(GetBishopAttacks(sq, occupancy) == GenerateBishopAttacks(sq, occupancy));
+            assert(attacks<Piece::Bishop>(sq, occupancy) == GenerateBishopAttacks(sq, occupancy));
+            assert(GetBishopAttacksCompact<uint8_t>(sq, occupancy) == GenerateBishopAttacks(sq, occupancy));
+        }
+        queries++;
+    });
+    cout << "All " << queries << " lookups from " << boards << " positions passed!" << endl;
+}
+
+volatile Bitboard BenchmarkSink;
+
+// Time `lookup` over a fixed query stream and report ns per lookup
+template<class LookupFunction>
+void BenchmarkLookup(const string &name, size_t tableBytes, const vector<pair<int, Bitboard>> &queries,
+                     int rounds, LookupFunction lookup) {
+    Bitboard checksum = 0;
+    auto start = chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++)
+        for (const auto &query : queries)
+            checksum ^= lookup(query.first, query.second);
+    auto elapsed = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    
+    // Keep the checksum alive so the loop is not optimised away
+    BenchmarkSink = checksum;
+    
+    cout << "  " << left << setw(24) << name << right
+         << fixed << setprecision(2) << setw(8) << elapsed / (double(rounds) * queries.size()) << " ns/lookup  "
+         << setw(9) << tableBytes << " bytes" << endl;
+    cout.unsetf(ios::floatfield);
+}
+
+// Keep an attack map along random games, updated incrementally or recomputed every move
+void BenchmarkAttackMap(int games = 2000) {
+    struct GameMove {
+        Position pos;
+        Move move;
+        bool firstOfGame;
+    };
+    vector<GameMove> moves;
+    std::mt19937_64 rng(12345);
+    for (int game = 0; game < games; game++) {
+        Position pos;
+        pos.SetFen(StartFen);
+        for (int ply = 0; ply < 150; ply++) {
+            MoveList legal;
+            GenerateLegalMoves(pos, legal);
+            if (legal.size() == 0) break;
+            Move move = legal[rng() % legal.size()];
+            moves.push_back({pos, move, ply == 0});
+            pos = pos.Play(move);
+        }
+    }
+    
+    cout << "\n=== Attack map maintenance (" << moves.size() << " moves of random games) ===" << endl;
+    for (bool incremental : {false, true}) {
+        AttackMap map;
+        uint64_t recomputed = 0, checksum = 0;
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < moves.size(); i++) {
+            const Position &pos = moves[i].pos;
+            Position next = pos.Play(moves[i].move);
+            if (incremental) {
+                if (moves[i].firstOfGame) map.Compute(pos);
+                recomputed += map.Update(pos, moves[i].move, next);
+            } else {
+                map.Compute(next);
+                recomputed += CountBits(next.occupied);
+            }
+            checksum ^= map.AttackersTo(i % 64);
+        }
+        auto elapsed = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+        BenchmarkSink = checksum;
+        cout << "  " << left << setw(24) << (incremental ? "incremental update" : "full recompute") << right
+             << fixed << setprecision(2) << setw(8) << elapsed / moves.size() << " ns/move  "
+             << setprecision(1) << setw(6) << double(recomputed) / moves.size() << " pieces/move" << endl;
+        cout.unsetf(ios::floatfield);
+    }
+}
+
+// Compare the flat and compressed layouts on the same query streams: the sliders
+// of a corpus when one is given, uniform random squares and occupancies otherwise
+void BenchmarkAttackLayouts(const OccupancyCorpus *corpus, int queryCount = 1 << 20, int rounds = 10) {
+    vector<pair<int, Bitboard>> rookQueries, bishopQueries;
+    if (corpus) {
+        corpus->ForEachQuery([&](Piece piece, int sq, Bitboard occupancy) {
+            auto &queries = piece == Piece::Rook ? rookQueries : bishopQueries;
+            if (int(queries.size()) < queryCount) queries.push_back({sq, occupancy});
+        });
+    } else {
+        std::mt19937_64 rng(12345);
+        std::uniform_int_distribution<uint64_t> dist(0, UINT64_MAX);
+        rookQueries.resize(queryCount);
+        for (auto &query : rookQueries)
+            query = {int(dist(rng) % 64), dist(rng)};
+        bishopQueries = rookQueries;
+    }
+    
+    size_t rookFlatBytes = 0, bishopFlatBytes = 0;
+    for (int sq = 0; sq < 64; sq++) {
+        rookFlatBytes += RookAttackSlices[sq].size * sizeof(Bitboard);
+        bishopFlatBytes += BishopAttackSlices[sq].size * sizeof(Bitboard);
+    }
+    
+    cout << "\n=== Attack table layout benchmark (" << (corpus ? "corpus, " : "random, ")
+         << rookQueries.size() << " rook / " << bishopQueries.size() << " bishop queries x " << rounds << ") ===" << endl;
+    BenchmarkLookup("rook flat", rookFlatBytes, rookQueries, rounds, GetRookAttacks);
+    BenchmarkLookup("rook attacks<Rook>", rookFlatBytes, rookQueries, rounds, attacks<Piece::Rook>);
+    BenchmarkLookup("rook compact 8-bit", CompactRookAttackTable<uint8_t>.Bytes(), rookQueries, rounds,
+                    GetRookAttacksCompact<uint8_t>);
+    BenchmarkLookup("rook compact 16-bit", CompactRookAttackTable<uint16_t>.Bytes(), rookQueries, rounds,
+                    GetRookAttacksCompact<uint16_t>);
+    // Mobility with the centre region, from popcounts of the attack set or from the byte table
+    BenchmarkLookup("rook popcount mobility", rookFlatBytes, rookQueries, rounds, [](int sq, Bitboard occupancy) {
+        Bitboard a = attacks<Piece::Rook>(sq, occupancy);
+        return Bitboard(CountBits(a) + CountBits(a & MobilityRegions[0]));
+    });
+    BenchmarkLookup("rook mobility table", rookFlatBytes / sizeof(Bitboard) * sizeof(MobilityEntry), rookQueries, rounds,
+                    [](int sq, Bitboard occupancy) {
+        MobilityEntry m = mobility<Piece::Rook>(sq, occupancy);
+        return Bitboard(m.total + m.regions[0]);
+    });
+    BenchmarkLookup("bishop flat", bishopFlatBytes, bishopQueries, rounds, GetBishopAttacks);
+    BenchmarkLookup("bishop attacks<Bishop>", bishopFlatBytes, bishopQueries, rounds, attacks<Piece::Bishop>);
+    BenchmarkLookup("bishop compact 8-bit", CompactBishopAttackTable<uint8_t>.Bytes(), bishopQueries, rounds,
+                    GetBishopAttacksCompact<uint8_t>);
+    BenchmarkLookup("bishop compact 16-bit", CompactBishopAttackTable<uint16_t>.Bytes(), bishopQueries, rounds,
+                    GetBishopAttacksCompact<uint16_t>);
+}
+
 void PrintRandomTestCases(int numCases = 5) {
     std::mt19937_64 rng(std::chrono::system_clock::now().time_since_epoch().count());
     std::uniform_int_distribution<uint64_t> dist(0, UINT64_MAX);
@@ -691,12 +988,29 @@ void PrintRandomTestCases(int numCases = 5) {
 }
 
 // Add this to your main function after all other tests
-int main() {
+// Pass --bench to also time the flat and compressed attack table layouts
+int main(int argc, char** argv) {
+    bool runBenchmarks = false;
+    string corpusPath;
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "--bench") runBenchmarks = true;
+        else if (string(argv[i]) == "--corpus" && i + 1 < argc) corpusPath = argv[++i];
+    }
+    
+    OccupancyCorpus corpus;
+    if (!corpusPath.empty() && !corpus.Open(corpusPath)) {
+        cerr << "Cannot open corpus " << corpusPath << endl;
+        return 1;
+    }
+    
     cout << "Initializing magic bitboards..." << endl;
     
-    // Initialize masks and attack tables
-    InitializeMasks();
+    // Initialize attack tables (masks are computed at compile time)
     InitializeAttackTables();
+    if (!InitializeCompactAttackTables()) {
+        cerr << "Compact attack tables could not be built" << endl;
+        return 1;
+    }
     
     cout << "Initialization complete." << endl;
     
@@ -721,11 +1035,27 @@ int main() {
     TestEdgeCases();
     TestSpecificProblemSquares();
     TestRandomizedSlidingAttacks(100000); // 100,000 iterations
+    TestCompactAttackTables();
+    TestLibraryLookups();
+    TestXrayAndLineTables();
+    TestMobilityTables();
+    TestVariantBoardLookups();
+    TestConstructiveSearch();
+    TestMagicDatabase();
+    TestLegalMoveGeneration();
+    TestAttackMap();
+    TestOccupancyCorpus();
+    if (!corpusPath.empty()) TestCorpusLookups(corpus);
     
     // Print some visual test cases to enjoy the success
     PrintRandomTestCases(5);
     
     cout << "All tests passed! Your magic bitboard implementation is working correctly." << endl;
     
+    if (runBenchmarks) {
+        BenchmarkAttackLayouts(corpusPath.empty() ? nullptr : &corpus);
+        BenchmarkAttackMap();
+    }
+    
     return 0;
 }
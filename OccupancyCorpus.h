@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "MagicBitboards.h"
+
+namespace magicbb {
+
+// Streaming reader for EPD/FEN files: the file is memory-mapped and each line's
+// piece placement is parsed in place, without allocating per line, into the
+// occupancy and the squares of the sliders on the board. Only the first field
+// is read, so EPD opcodes and FEN move counters are ignored.
+//
+//   OccupancyCorpus corpus;
+//   if (corpus.Open("games.epd"))
+//       corpus.ForEachQuery([](Piece piece, int sq, Bitboard occupancy) { ... });
+
+struct CorpusBoard {
+    Bitboard occupancy;
+    Bitboard rookSliders;    // rooks and queens of both colors
+    Bitboard bishopSliders;  // bishops and queens of both colors
+};
+
+class OccupancyCorpus {
+public:
+    OccupancyCorpus() = default;
+    ~OccupancyCorpus() { Close(); }
+
+    OccupancyCorpus(const OccupancyCorpus &) = delete;
+    OccupancyCorpus &operator=(const OccupancyCorpus &) = delete;
+
+    bool Open(const std::string &path) {
+        Close();
+#ifdef __linux__
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            close(fd);
+            return false;
+        }
+        // An empty file is an empty corpus (mmap rejects zero-length mappings)
+        if (info.st_size == 0) {
+            close(fd);
+            return true;
+        }
+        size_ = size_t(info.st_size);
+        void *memory = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (memory != MAP_FAILED) {
+            madvise(memory, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const char *>(memory);
+            mapped_ = true;
+        }
+        close(fd);
+        if (mapped_) return true;
+        size_ = 0;
+#endif
+        // No mmap: read the whole file into one buffer
+        FILE *file = std::fopen(path.c_str(), "rb");
+        if (!file) return false;
+        std::fseek(file, 0, SEEK_END);
+        size_ = size_t(std::ftell(file));
+        std::fseek(file, 0, SEEK_SET);
+        char *buffer = static_cast<char *>(std::malloc(size_ ? size_ : 1));
+        size_ = buffer ? std::fread(buffer, 1, size_, file) : 0;
+        std::fclose(file);
+        data_ = buffer;
+        return buffer != nullptr;
+    }
+
+    void Close() {
+        if (!data_) return;
+#ifdef __linux__
+        if (mapped_) munmap(const_cast<char *>(data_), size_);
+        else std::free(const_cast<char *>(data_));
+#else
+        std::free(const_cast<char *>(data_));
+#endif
+        data_ = nullptr;
+        size_ = 0;
+        mapped_ = false;
+    }
+
+    size_t Bytes() const { return size_; }
+
+    // Parse the next board, skipping blank, comment ('#') and malformed lines.
+    // `cursor` is a byte offset into the file; start at 0. Returns false at the end.
+    bool Next(size_t &cursor, CorpusBoard &board) const {
+        while (cursor < size_) {
+            const char *line = data_ + cursor;
+            const char *end = static_cast<const char *>(memchr(line, '\n', size_ - cursor));
+            if (!end) end = data_ + size_;
+            cursor = size_t(end - data_) + 1;
+            if (ParsePlacement(line, end, board)) return true;
+        }
+        return false;
+    }
+
+    // Call visit(piece, sq, occupancy) for every rook-like and bishop-like slider of every board;
+    // queens yield one rook and one bishop query. Returns the number of boards read.
+    template<class Visitor> size_t ForEachQuery(Visitor &&visit) const {
+        size_t cursor = 0, boards = 0;
+        CorpusBoard board;
+        while (Next(cursor, board)) {
+            for (Bitboard b = board.rookSliders; b; b &= b - 1)
+                visit(Piece::Rook, __builtin_ctzll(b), board.occupancy);
+            for (Bitboard b = board.bishopSliders; b; b &= b - 1)
+                visit(Piece::Bishop, __builtin_ctzll(b), board.occupancy);
+            boards++;
+        }
+        return boards;
+    }
+
+private:
+    static bool ParsePlacement(const char *p, const char *end, CorpusBoard &board) {
+        while (p < end && (*p == ' ' || *p == '\t')) p++;
+        if (p == end || *p == '#' || *p == '\r') return false;
+
+        board = CorpusBoard{0, 0, 0};
+        int rank = 7, file = 0;
+        for (; p < end && *p != ' ' && *p != '\t' && *p != '\r'; p++) {
+            char c = *p;
+            if (c == '/') {
+                if (file != 8 || rank == 0) return false;
+                rank--;
+                file = 0;
+            } else if (c >= '1' && c <= '8') {
+                file += c - '0';
+                if (file > 8) return false;
+            } else {
+                if (file > 7) return false;
+                Bitboard bit = Bitboard(1) << (rank * 8 + file++);
+                switch (c | 0x20) {
+                    case 'q': board.rookSliders |= bit; board.bishopSliders |= bit; break;
+                    case 'r': board.rookSliders |= bit; break;
+                    case 'b': board.bishopSliders |= bit; break;
+                    case 'p': case 'n': case 'k': break;
+                    default: return false;
+                }
+                board.occupancy |= bit;
+            }
+        }
+        return rank == 0 && file == 8;
+    }
+
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+};
+
+}  // namespace magicbb
@@ -0,0 +1,178 @@
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <atomic>
+#include <algorithm>
+#include <iomanip>
+#include <string>
+
+#include "CpuTopology.h"
+#include "MagicBitboards.h"
+#include "Position.h"
+
+using namespace std;
+using namespace magicbb;
+using namespace chrono;
+
+// Multithreaded perft: counts leaf nodes of the legal move tree and reports
+// nodes per second, so magic sets and table layouts can be compared end to end.
+
+struct PerftOptions {
+    string fen = StartFen;
+    int depth = 5;
+    bool verify = false;
+    bool divide = false;
+    int threadCount = 0;
+    AffinityPolicy policy = AffinityPolicy::Auto;
+};
+
+// Positions after `plies` moves from root; each one becomes a unit of work
+void ExpandPositions(const Position &root, int plies, vector<Position> &positions) {
+    if (plies == 0) {
+        positions.push_back(root);
+        return;
+    }
+    MoveList moves;
+    GenerateLegalMoves(root, moves);
+    for (Move move : moves)
+        ExpandPositions(root.Play(move), plies - 1, positions);
+}
+
+// Split the tree two plies down so a few hundred work items keep every thread busy
+uint64_t ParallelPerft(const Position &root, int depth, const vector<int> &cpuOrder, int threadCount) {
+    int splitPlies = min(2, max(0, depth - 1));
+    vector<Position> work;
+    ExpandPositions(root, splitPlies, work);
+
+    atomic<size_t> next(0);
+    atomic<uint64_t> total(0);
+    vector<thread> threads;
+    for (int i = 0; i < threadCount; i++) {
+        threads.emplace_back([&, i] {
+            if (!cpuOrder.empty()) PinCurrentThread(cpuOrder[i % cpuOrder.size()]);
+            uint64_t nodes = 0;
+            for (size_t k; (k = next++) < work.size(); )
+                nodes += Perft(work[k], depth - splitPlies);
+            total += nodes;
+        });
+    }
+    for (auto &t : threads)
+        t.join();
+    return total;
+}
+
+// Run one perft and print its node count and speed; returns the node count
+uint64_t TimedPerft(const Position &root, int depth, const vector<int> &cpuOrder, int threadCount) {
+    auto start = steady_clock::now();
+    uint64_t nodes = ParallelPerft(root, depth, cpuOrder, threadCount);
+    double seconds = duration<double>(steady_clock::now() - start).count();
+    cout << "  depth " << depth << ": " << setw(12) << nodes << " nodes  "
+         << fixed << setprecision(3) << seconds << " s  "
+         << setprecision(2) << (seconds > 0 ? nodes / seconds / 1e6 : 0.0) << " Mnodes/s\n";
+    return nodes;
+}
+
+void PrintUsage(const char *program) {
+    cout << "Usage: " << program << " [--fen FEN] [--depth N] [--verify] [--divide] [--threads N]\n"
+         << "       [--affinity auto|none|compact|scatter|physical]\n"
+         << "  --fen FEN       position to search (default: the start position)\n"
+         << "  --depth N       perft depth (default 5)\n"
+         << "  --verify        run the standard positions up to --depth and check the counts\n"
+         << "  --divide        print the node count below every root move\n"
+         << "  --threads N     number of worker threads (default: all logical cpus)\n"
+         << "  --affinity P    how workers are pinned to cpus; auto spreads them over\n"
+         << "                  physical cores first\n";
+}
+
+int main(int argc, char** argv) {
+    PerftOptions options;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--fen" && i + 1 < argc) {
+            options.fen = argv[++i];
+        } else if (arg == "--depth" && i + 1 < argc) {
+            options.depth = atoi(argv[++i]);
+            if (options.depth < 1) {
+                cerr << "--depth expects a positive number\n";
+                return 1;
+            }
+        } else if (arg == "--verify") {
+            options.verify = true;
+        } else if (arg == "--divide") {
+            options.divide = true;
+        } else if (arg == "--threads" && i + 1 < argc) {
+            options.threadCount = atoi(argv[++i]);
+            if (options.threadCount <= 0) {
+                cerr << "--threads expects a positive number\n";
+                return 1;
+            }
+        } else if (arg == "--affinity" && i + 1 < argc) {
+            if (!ParseAffinityPolicy(argv[++i], options.policy)) {
+                cerr << "Unknown affinity policy: " << argv[i] << "\n";
+                return 1;
+            }
+        } else {
+            PrintUsage(argv[0]);
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    InitializeAttackTables();
+
+    CpuTopology topology = DetectTopology();
+    int threadCount = options.threadCount > 0 ? options.threadCount : int(topology.cpus.size());
+    // Perft has no calibration step: auto simply fills physical cores before SMT siblings
+    AffinityPolicy policy = options.policy == AffinityPolicy::Auto ? AffinityPolicy::Scatter : options.policy;
+    vector<int> cpuOrder;
+    if (policy != AffinityPolicy::None) cpuOrder = PlanCpuOrder(topology, policy);
+    cout << "Using " << threadCount << " threads, affinity " << AffinityPolicyName(policy) << "\n";
+
+    if (options.verify) {
+        bool allPassed = true;
+        uint64_t totalNodes = 0;
+        auto start = steady_clock::now();
+        for (const PerftCase &test : StandardPerftPositions) {
+            Position pos;
+            pos.SetFen(test.fen);
+            cout << test.name << ": " << test.fen << "\n";
+            for (int depth = 1; depth <= min<int>(options.depth, test.nodes.size()); depth++) {
+                uint64_t nodes = TimedPerft(pos, depth, cpuOrder, threadCount);
+                totalNodes += nodes;
+                if (nodes != test.nodes[depth - 1]) {
+                    cout << "  MISMATCH: expected " << test.nodes[depth - 1] << "\n";
+                    allPassed = false;
+                }
+            }
+        }
+        double seconds = duration<double>(steady_clock::now() - start).count();
+        cout << (allPassed ? "All perft counts match" : "Perft counts differ") << ", "
+             << totalNodes << " nodes in " << fixed << setprecision(3) << seconds << " s ("
+             << setprecision(2) << totalNodes / seconds / 1e6 << " Mnodes/s)\n";
+        return allPassed ? 0 : 1;
+    }
+
+    Position root;
+    if (!root.SetFen(options.fen)) {
+        cerr << "Invalid FEN: " << options.fen << "\n";
+        return 1;
+    }
+    cout << root.Fen() << "\n";
+
+    if (options.divide) {
+        MoveList moves;
+        GenerateLegalMoves(root, moves);
+        uint64_t total = 0;
+        for (Move move : moves) {
+            uint64_t nodes = ParallelPerft(root.Play(move), options.depth - 1, cpuOrder, threadCount);
+            cout << MoveToUci(move) << ": " << nodes << "\n";
+            total += nodes;
+        }
+        cout << "Total: " << total << "\n";
+        return 0;
+    }
+
+    TimedPerft(root, options.depth, cpuOrder, threadCount);
+    return 0;
+}
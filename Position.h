@@ -0,0 +1,421 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+
+#include "MagicBitboards.h"
+
+namespace magicbb {
+
+// Board representation, FEN parsing and a legal move generator built on the
+// magic slider lookups, plus perft for checking and timing it end to end.
+// Moves are applied by copying the position (copy-make); nothing is undone.
+//
+//   Position pos;
+//   pos.SetFen(StartFen);
+//   MoveList moves;
+//   GenerateLegalMoves(pos, moves);
+//   Position next = pos.Play(moves[0]);
+
+enum Color : int { White, Black };
+
+enum PieceType : int { Pawn, Knight, Bishop, Rook, Queen, King };
+
+enum CastlingRight : int {
+    WhiteKingside = 1, WhiteQueenside = 2, BlackKingside = 4, BlackQueenside = 8
+};
+
+constexpr const char *StartFen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+inline int LowestBit(Bitboard b) {
+    return __builtin_ctzll(b);
+}
+
+// Knight, king and pawn attack tables
+template<int Count> constexpr std::array<Bitboard, 64> GenerateStepAttacks(const int (&steps)[Count][2]) {
+    std::array<Bitboard, 64> table{};
+    for (int sq = 0; sq < 64; sq++)
+        for (int i = 0; i < Count; i++) {
+            int rank = sq / 8 + steps[i][0], file = sq % 8 + steps[i][1];
+            if (rank >= 0 && rank < 8 && file >= 0 && file < 8)
+                table[sq] |= Bitboard(1) << (rank * 8 + file);
+        }
+    return table;
+}
+
+constexpr int KnightSteps[8][2] = {{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+constexpr int KingSteps[8][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+constexpr int WhitePawnSteps[2][2] = {{1, -1}, {1, 1}};
+constexpr int BlackPawnSteps[2][2] = {{-1, -1}, {-1, 1}};
+
+constexpr std::array<Bitboard, 64> KnightAttacks = GenerateStepAttacks(KnightSteps);
+constexpr std::array<Bitboard, 64> KingAttacks = GenerateStepAttacks(KingSteps);
+constexpr std::array<Bitboard, 64> PawnAttacks[2] = {GenerateStepAttacks(WhitePawnSteps),
+                                                    GenerateStepAttacks(BlackPawnSteps)};
+
+// Moves pack from (bits 0-5), to (6-11), kind (12-13) and the promotion piece
+// (14-15, Knight..Queen). Castling is encoded as the king's two-square move.
+using Move = uint16_t;
+
+enum MoveKind : int { NormalMove, PromotionMove, EnPassantMove, CastlingMove };
+
+constexpr Move MakeMove(int from, int to, MoveKind kind = NormalMove, PieceType promotion = Knight) {
+    return Move(from | (to << 6) | (kind << 12) | ((promotion - Knight) << 14));
+}
+
+constexpr int MoveFrom(Move move) { return move & 63; }
+constexpr int MoveTo(Move move) { return (move >> 6) & 63; }
+constexpr MoveKind MoveKindOf(Move move) { return MoveKind((move >> 12) & 3); }
+constexpr PieceType MovePromotion(Move move) { return PieceType(Knight + (move >> 14)); }
+
+inline std::string SquareName(int sq) {
+    return std::string{char('a' + sq % 8), char('1' + sq / 8)};
+}
+
+inline std::string MoveToUci(Move move) {
+    std::string text = SquareName(MoveFrom(move)) + SquareName(MoveTo(move));
+    if (MoveKindOf(move) == PromotionMove) text += "nbrq"[MovePromotion(move) - Knight];
+    return text;
+}
+
+// At most 218 legal moves exist in any chess position
+struct MoveList {
+    std::array<Move, 256> moves;
+    int count = 0;
+
+    void Add(Move move) { moves[count++] = move; }
+    Move operator[](int i) const { return moves[i]; }
+    int size() const { return count; }
+    const Move *begin() const { return moves.data(); }
+    const Move *end() const { return moves.data() + count; }
+};
+
+// Castling rights that survive a move touching each square
+constexpr std::array<int, 64> GenerateCastlingMasks() {
+    std::array<int, 64> masks{};
+    for (int sq = 0; sq < 64; sq++) masks[sq] = 15;
+    masks[A1] &= ~WhiteQueenside;
+    masks[H1] &= ~WhiteKingside;
+    masks[E1] &= ~(WhiteKingside | WhiteQueenside);
+    masks[A8] &= ~BlackQueenside;
+    masks[H8] &= ~BlackKingside;
+    masks[E8] &= ~(BlackKingside | BlackQueenside);
+    return masks;
+}
+
+constexpr std::array<int, 64> CastlingMasks = GenerateCastlingMasks();
+
+struct Position {
+    static constexpr uint8_t NoPiece = 12;
+
+    std::array<std::array<Bitboard, 6>, 2> pieces{};  // [color][piece type]
+    std::array<Bitboard, 2> colors{};
+    Bitboard occupied = 0;
+    std::array<uint8_t, 64> board{};                  // color * 6 + piece type, or NoPiece
+    Color sideToMove = White;
+    int castling = 0;
+    int enPassant = -1;                               // square a pawn can capture onto en passant
+    int halfmoveClock = 0;
+    int fullmoveNumber = 1;
+
+    void Clear() {
+        *this = Position();
+        board.fill(NoPiece);
+    }
+
+    void Put(Color color, PieceType type, int sq) {
+        Bitboard bit = BIT<Bitboard>(sq);
+        pieces[color][type] |= bit;
+        colors[color] |= bit;
+        occupied |= bit;
+        board[sq] = uint8_t(color * 6 + type);
+    }
+
+    void Remove(int sq) {
+        Bitboard bit = BIT<Bitboard>(sq);
+        pieces[board[sq] / 6][board[sq] % 6] ^= bit;
+        colors[board[sq] / 6] ^= bit;
+        occupied ^= bit;
+        board[sq] = NoPiece;
+    }
+
+    int KingSquare(Color color) const {
+        return LowestBit(pieces[color][King]);
+    }
+
+    // Pieces of either color attacking sq, with sliders seeing through `occupancy`
+    Bitboard AttackersTo(int sq, Bitboard occupancy) const {
+        Bitboard rookLike = pieces[White][Rook] | pieces[Black][Rook] | pieces[White][Queen] | pieces[Black][Queen];
+        Bitboard bishopLike = pieces[White][Bishop] | pieces[Black][Bishop] | pieces[White][Queen] | pieces[Black][Queen];
+        return (PawnAttacks[White][sq] & pieces[Black][Pawn]) |
+               (PawnAttacks[Black][sq] & pieces[White][Pawn]) |
+               (KnightAttacks[sq] & (pieces[White][Knight] | pieces[Black][Knight])) |
+               (KingAttacks[sq] & (pieces[White][King] | pieces[Black][King])) |
+               (GetBishopAttacks(sq, occupancy) & bishopLike) |
+               (GetRookAttacks(sq, occupancy) & rookLike);
+    }
+
+    bool InCheck() const {
+        return AttackersTo(KingSquare(sideToMove), occupied) & colors[sideToMove ^ 1];
+    }
+
+    // Parse a FEN string; the move counters may be omitted. Returns false on malformed input.
+    bool SetFen(const std::string &fen) {
+        Clear();
+        std::istringstream fields(fen);
+        std::string placement, side, rights, passant;
+        if (!(fields >> placement >> side >> rights >> passant)) return false;
+        if (!(fields >> halfmoveClock)) halfmoveClock = 0;
+        if (!(fields >> fullmoveNumber)) fullmoveNumber = 1;
+
+        int rank = 7, file = 0;
+        for (char c : placement) {
+            if (c == '/') {
+                if (file != 8 || rank == 0) return false;
+                rank--;
+                file = 0;
+            } else if (c >= '1' && c <= '8') {
+                file += c - '0';
+            } else {
+                size_t type = std::string("pnbrqk").find(c | 0x20);
+                if (type == std::string::npos || file > 7) return false;
+                Put(c >= 'a' ? Black : White, PieceType(type), rank * 8 + file++);
+            }
+            if (file > 8) return false;
+        }
+        if (rank != 0 || file != 8) return false;
+        if (CountBits(pieces[White][King]) != 1 || CountBits(pieces[Black][King]) != 1) return false;
+        if ((pieces[White][Pawn] | pieces[Black][Pawn]) & 0xFF000000000000FFULL) return false;
+
+        if (side != "w" && side != "b") return false;
+        sideToMove = side == "w" ? White : Black;
+
+        for (char c : rights) {
+            size_t right = std::string("KQkq").find(c);
+            if (right != std::string::npos) castling |= 1 << right;
+            else if (c != '-') return false;
+        }
+        // Drop rights whose king or rook is not on its home square
+        const int rightSquares[4][2] = {{E1, H1}, {E1, A1}, {E8, H8}, {E8, A8}};
+        for (int right = 0; right < 4; right++) {
+            Color color = right < 2 ? White : Black;
+            if (!(pieces[color][King] & BIT<Bitboard>(rightSquares[right][0])) ||
+                !(pieces[color][Rook] & BIT<Bitboard>(rightSquares[right][1])))
+                castling &= ~(1 << right);
+        }
+
+        if (passant != "-") {
+            if (passant.size() != 2 || passant[0] < 'a' || passant[0] > 'h' ||
+                passant[1] != (sideToMove == White ? '6' : '3'))
+                return false;
+            enPassant = (passant[1] - '1') * 8 + (passant[0] - 'a');
+            // Play removes the pawn behind the square, so the double push must have happened
+            int pushed = enPassant + (sideToMove == White ? -8 : 8);
+            if (board[enPassant] != NoPiece || !(pieces[sideToMove ^ 1][Pawn] & BIT<Bitboard>(pushed)))
+                return false;
+        }
+        // The side that just moved cannot have left its king in check
+        if (AttackersTo(KingSquare(Color(sideToMove ^ 1)), occupied) & colors[sideToMove]) return false;
+        return true;
+    }
+
+    std::string Fen() const {
+        std::string fen;
+        for (int rank = 7; rank >= 0; rank--) {
+            int empty = 0;
+            for (int file = 0; file < 8; file++) {
+                uint8_t piece = board[rank * 8 + file];
+                if (piece == NoPiece) { empty++; continue; }
+                if (empty) fen += char('0' + empty);
+                empty = 0;
+                fen += "PNBRQKpnbrqk"[piece];
+            }
+            if (empty) fen += char('0' + empty);
+            if (rank) fen += '/';
+        }
+        fen += sideToMove == White ? " w " : " b ";
+        for (int right = 0; right < 4; right++)
+            if (castling & (1 << right)) fen += "KQkq"[right];
+        if (!castling) fen += '-';
+        fen += ' ' + (enPassant < 0 ? std::string("-") : SquareName(enPassant));
+        fen += ' ' + std::to_string(halfmoveClock) + ' ' + std::to_string(fullmoveNumber);
+        return fen;
+    }
+
+    // Position after a legal move
+    Position Play(Move move) const {
+        Position next = *this;
+        int from = MoveFrom(move), to = MoveTo(move);
+        Color us = sideToMove;
+        PieceType type = PieceType(board[from] % 6);
+
+        next.enPassant = -1;
+        next.halfmoveClock++;
+        if (board[to] != NoPiece) {
+            next.Remove(to);
+            next.halfmoveClock = 0;
+        }
+        next.Remove(from);
+        next.Put(us, MoveKindOf(move) == PromotionMove ? MovePromotion(move) : type, to);
+
+        if (type == Pawn) {
+            next.halfmoveClock = 0;
+            if (MoveKindOf(move) == EnPassantMove) next.Remove(to + (us == White ? -8 : 8));
+            if (std::abs(to - from) == 16) next.enPassant = (from + to) / 2;
+        } else if (MoveKindOf(move) == CastlingMove) {
+            // King already moved; bring the rook across it
+            int rookFrom = to > from ? to + 1 : to - 2, rookTo = to > from ? to - 1 : to + 1;
+            next.Remove(rookFrom);
+            next.Put(us, Rook, rookTo);
+        }
+
+        next.castling &= CastlingMasks[from] & CastlingMasks[to];
+        if (us == Black) next.fullmoveNumber++;
+        next.sideToMove = Color(us ^ 1);
+        return next;
+    }
+};
+
+inline void AddPawnMoves(MoveList &list, int from, int to) {
+    if (to >= A8 || to <= H1) {
+        for (PieceType promotion : {Queen, Rook, Bishop, Knight})
+            list.Add(MakeMove(from, to, PromotionMove, promotion));
+    } else {
+        list.Add(MakeMove(from, to));
+    }
+}
+
+// Every legal move for the side to move
+inline void GenerateLegalMoves(const Position &pos, MoveList &list) {
+    list.count = 0;
+    Color us = pos.sideToMove, them = Color(us ^ 1);
+    Bitboard own = pos.colors[us], enemy = pos.colors[them], occupied = pos.occupied;
+    int king = pos.KingSquare(us);
+    Bitboard checkers = pos.AttackersTo(king, occupied) & enemy;
+
+    // King steps; the king is lifted off the board so it cannot hide behind itself
+    Bitboard kingless = occupied ^ BIT<Bitboard>(king);
+    for (Bitboard targets = KingAttacks[king] & ~own; targets; targets &= targets - 1) {
+        int to = LowestBit(targets);
+        if (!(pos.AttackersTo(to, kingless) & enemy)) list.Add(MakeMove(king, to));
+    }
+    if (CountBits(checkers) > 1) return;
+
+    // Other moves must capture or block a single checker
+    Bitboard targetMask = ~own;
+    if (checkers) targetMask = checkers | Between[king][LowestBit(checkers)];
+
+    // Pieces pinned to the king may only move along the pin line: an enemy slider
+    // seen from the king through exactly one own piece pins that piece
+    Bitboard enemyRooks = pos.pieces[them][Rook] | pos.pieces[them][Queen];
+    Bitboard enemyBishops = pos.pieces[them][Bishop] | pos.pieces[them][Queen];
+    Bitboard snipers = (GetRookXrayAttacks(king, occupied, own) & enemyRooks) |
+                       (GetBishopXrayAttacks(king, occupied, own) & enemyBishops);
+    Bitboard pinned = 0;
+    for (; snipers; snipers &= snipers - 1)
+        pinned |= Between[king][LowestBit(snipers)] & own;
+    auto pinMask = [&](int from) {
+        return (pinned & BIT<Bitboard>(from)) ? Line[king][from] : ~Bitboard(0);
+    };
+
+    for (Bitboard knights = pos.pieces[us][Knight] & ~pinned; knights; knights &= knights - 1) {
+        int from = LowestBit(knights);
+        for (Bitboard targets = KnightAttacks[from] & targetMask; targets; targets &= targets - 1)
+            list.Add(MakeMove(from, LowestBit(targets)));
+    }
+
+    for (Bitboard bishops = pos.pieces[us][Bishop] | pos.pieces[us][Queen]; bishops; bishops &= bishops - 1) {
+        int from = LowestBit(bishops);
+        Bitboard targets = GetBishopAttacks(from, occupied) & targetMask & pinMask(from);
+        for (; targets; targets &= targets - 1)
+            list.Add(MakeMove(from, LowestBit(targets)));
+    }
+
+    for (Bitboard rooks = pos.pieces[us][Rook] | pos.pieces[us][Queen]; rooks; rooks &= rooks - 1) {
+        int from = LowestBit(rooks);
+        Bitboard targets = GetRookAttacks(from, occupied) & targetMask & pinMask(from);
+        for (; targets; targets &= targets - 1)
+            list.Add(MakeMove(from, LowestBit(targets)));
+    }
+
+    int forward = us == White ? 8 : -8;
+    int doublePushRank = us == White ? 1 : 6;
+    for (Bitboard pawns = pos.pieces[us][Pawn]; pawns; pawns &= pawns - 1) {
+        int from = LowestBit(pawns);
+        Bitboard allowed = targetMask & pinMask(from);
+
+        int one = from + forward;
+        if (!(occupied & BIT<Bitboard>(one))) {
+            if (allowed & BIT<Bitboard>(one)) AddPawnMoves(list, from, one);
+            int two = one + forward;
+            if (from / 8 == doublePushRank && !(occupied & BIT<Bitboard>(two)) && (allowed & BIT<Bitboard>(two)))
+                list.Add(MakeMove(from, two));
+        }
+        for (Bitboard targets = PawnAttacks[us][from] & enemy & allowed; targets; targets &= targets - 1)
+            AddPawnMoves(list, from, LowestBit(targets));
+
+        // En passant removes two pieces from one line, so test the resulting position directly
+        if (pos.enPassant >= 0 && (PawnAttacks[us][from] & BIT<Bitboard>(pos.enPassant))) {
+            int captured = pos.enPassant - forward;
+            Bitboard after = occupied ^ BIT<Bitboard>(from) ^ BIT<Bitboard>(captured) ^ BIT<Bitboard>(pos.enPassant);
+            if (!(pos.AttackersTo(king, after) & enemy & ~BIT<Bitboard>(captured)))
+                list.Add(MakeMove(from, pos.enPassant, EnPassantMove));
+        }
+    }
+
+    // Castling: rights, the rook in its corner, empty squares up to it, and no
+    // attacked square on the king's path
+    if (!checkers) {
+        int rights = pos.castling >> (us == White ? 0 : 2);  // this side's rights in the white bits
+        int home = us == White ? E1 : E8;
+        Bitboard rooks = pos.pieces[us][Rook];
+        auto safe = [&](int sq) { return !(pos.AttackersTo(sq, occupied) & enemy); };
+        if ((rights & WhiteKingside) && (rooks & BIT<Bitboard>(home + 3)) &&
+            !(occupied & (BIT<Bitboard>(home + 1) | BIT<Bitboard>(home + 2))) &&
+            safe(home + 1) && safe(home + 2))
+            list.Add(MakeMove(home, home + 2, CastlingMove));
+        if ((rights & WhiteQueenside) && (rooks & BIT<Bitboard>(home - 4)) &&
+            !(occupied & (BIT<Bitboard>(home - 1) | BIT<Bitboard>(home - 2) | BIT<Bitboard>(home - 3))) &&
+            safe(home - 1) && safe(home - 2))
+            list.Add(MakeMove(home, home - 2, CastlingMove));
+    }
+}
+
+// Leaf nodes at `depth`; the last ply is counted from the move list without playing it
+inline uint64_t Perft(const Position &pos, int depth) {
+    if (depth == 0) return 1;
+    MoveList moves;
+    GenerateLegalMoves(pos, moves);
+    if (depth == 1) return moves.size();
+    uint64_t nodes = 0;
+    for (Move move : moves)
+        nodes += Perft(pos.Play(move), depth - 1);
+    return nodes;
+}
+
+// Reference positions with published perft counts; nodes[d - 1] is the count at depth d
+struct PerftCase {
+    const char *name;
+    const char *fen;
+    std::array<uint64_t, 6> nodes;
+};
+
+inline constexpr PerftCase StandardPerftPositions[] = {
+    {"start", StartFen,
+     {20, 400, 8902, 197281, 4865609, 119060324}},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+     {48, 2039, 97862, 4085603, 193690690, 8031647685}},
+    {"position 3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+     {14, 191, 2812, 43238, 674624, 11030083}},
+    {"position 4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+     {6, 264, 9467, 422333, 15833292, 706045033}},
+    {"position 5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+     {44, 1486, 62379, 2103487, 89941194, 3048196529}},
+    {"position 6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+     {46, 2079, 89890, 3894594, 164075551, 6923051137}},
+};
+
+}  // namespace magicbb
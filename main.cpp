@@ -7,163 +7,93 @@
 #include <random>
 #include <atomic>
 #include <algorithm>
+#include <cmath>
 #include <iomanip>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+#include "ConstructiveSearch.h"
+#include "CpuTopology.h"
+#include "HugePageMemory.h"
+#include "MagicDatabase.h"
+#include "MagicBitboards.h"
 
 using namespace std;
+using namespace magicbb;
 using namespace chrono;
 
-using bitboard = uint64_t;
 using magicNumber = uint64_t;
 
 // Improved random number generation
 thread_local mt19937_64 rng(random_device{}());
 thread_local uniform_int_distribution<uint64_t> dist(0, UINT64_MAX);
 
-// Bit manipulation utilities
-template<class IntegerType> inline IntegerType BIT(const IntegerType &x) {
-    return (IntegerType(1) << x);
-}
+// Magic output structure
+struct MagicOutput {
+    magicNumber number;
+    int shift;
+    int tableSize;
+    MagicOutput() : number(0), shift(64), tableSize(0) {}
+};
 
-template<class IntegerType> inline bool IsBitSet(const IntegerType &objectToCheck, const int &bitIndex) {
-    return (objectToCheck >> bitIndex) & 1;
-}
+// Read-only view of one square's blocker subsets inside a SearchTables arena,
+// with the reference attack set of each subset alongside
+template<class Word> struct BlockerArray {
+    const Word *first;
+    const Word *references;
+    size_t count;
+    const Word *begin() const { return first; }
+    const Word *end() const { return first + count; }
+    size_t size() const { return count; }
+};
 
-template<class IntegerType> inline void SetBit(IntegerType &objectToSet, const int &bitIndex) {
-    objectToSet |= BIT<IntegerType>(bitIndex);
-}
+// A (piece, square) pair the workers search a magic for, at a target index size
+struct WorkItem {
+    bool isBishop;
+    int sq;
+    int indexBits;
+};
 
-// Generate rook moves mask (excluding edges)
-bitboard GenerateRookMovesMaskAtSquare(int sqr) {
-    bitboard output = 0;
-    int row = sqr / 8, col = sqr % 8;
-    
-    // Up (excluding edge)
-    for (int r = row + 1; r < 7; r++) 
-        SetBit(output, r * 8 + col);
-    
-    // Down (excluding edge)
-    for (int r = row - 1; r > 0; r--) 
-        SetBit(output, r * 8 + col);
-    
-    // Right (excluding edge)
-    for (int c = col + 1; c < 7; c++) 
-        SetBit(output, row * 8 + c);
-    
-    // Left (excluding edge)
-    for (int c = col - 1; c > 0; c--) 
-        SetBit(output, row * 8 + c);
-    
-    return output;
+// Rook squares occupy the first G::Squares slots of the per-item arrays, bishop squares the rest
+template<class G> inline int ItemIndex(bool isBishop, int sq) {
+    return (isBishop ? G::Squares : 0) + sq;
 }
 
-bitboard GenerateBishopMovesMaskAtSquare(int sqr) {
-    bitboard output = 0;
-    int row = sqr / 8, col = sqr % 8;
-    
-    // Down-Right (excluding edges)
-    for (int r = row + 1, c = col + 1; r < 7 && c < 7; r++, c++) 
-        SetBit(output, r * 8 + c);
-    
-    // Down-Left (excluding edges)
-    for (int r = row + 1, c = col - 1; r < 7 && c > 0; r++, c--) 
-        SetBit(output, r * 8 + c);
-    
-    // Up-Right (excluding edges)
-    for (int r = row - 1, c = col + 1; r > 0 && c < 7; r--, c++) 
-        SetBit(output, r * 8 + c);
-    
-    // Up-Left (excluding edges)
-    for (int r = row - 1, c = col - 1; r > 0 && c > 0; r--, c--) 
-        SetBit(output, r * 8 + c);
-    
-    return output;
-}
+// Masks and blocker subsets for every rook and bishop square, packed into one
+// huge-page arena. One copy is built per NUMA node so workers never read
+// blockers across sockets.
+template<class G> struct SearchTables {
+    using Word = typename G::Word;
 
-// Generate actual rook attacks considering blockers
-bitboard GenerateRookAttacks(int sq, bitboard blockers) {
-    bitboard attacks = 0;
-    int row = sq / 8, col = sq % 8;
-    
-    // Up
-    for (int r = row + 1; r < 8; r++) {
-        int target = r * 8 + col;
-        SetBit(attacks, target);
-        if (IsBitSet(blockers, target)) break;
-    }
-    // Down
-    for (int r = row - 1; r >= 0; r--) {
-        int target = r * 8 + col;
-        SetBit(attacks, target);
-        if (IsBitSet(blockers, target)) break;
-    }
-    // Right
-    for (int c = col + 1; c < 8; c++) {
-        int target = row * 8 + c;
-        SetBit(attacks, target);
-        if (IsBitSet(blockers, target)) break;
-    }
-    // Left
-    for (int c = col - 1; c >= 0; c--) {
-        int target = row * 8 + c;
-        SetBit(attacks, target);
-        if (IsBitSet(blockers, target)) break;
-    }
-    
-    return attacks;
-}
+    Word masks[2 * G::Squares];
+    size_t offsets[2 * G::Squares + 1];
+    HugePageBuffer<Word> blockers;
+    HugePageBuffer<Word> references;   // attack set of blockers[i], same layout
 
-// Generate actual bishop attacks considering blockers
-bitboard GenerateBishopAttacks(int sq, bitboard blockers) {
-    bitboard attacks = 0;
-    int row = sq / 8, col = sq % 8;
-    
-    // Down-right
-    for (int r = row + 1, c = col + 1; r < 8 && c < 8; r++, c++) {
-        int target = r * 8 + c;
-        SetBit(attacks, target);
-        if (IsBitSet(blockers, target)) break;
-    }
-    // Down-left
-    for (int r = row + 1, c = col - 1; r < 8 && c >= 0; r++, c--) {
-        int target = r * 8 + c;
-        SetBit(attacks, target);
-        if (IsBitSet(blockers, target)) break;
-    }
-    // Up-right
-    for (int r = row - 1, c = col + 1; r >= 0 && c < 8; r--, c++) {
-        int target = r * 8 + c;
-        SetBit(attacks, target);
-        if (IsBitSet(blockers, target)) break;
-    }
-    // Up-left
-    for (int r = row - 1, c = col - 1; r >= 0 && c >= 0; r--, c--) {
-        int target = r * 8 + c;
-        SetBit(attacks, target);
-        if (IsBitSet(blockers, target)) break;
+    Word Mask(bool isBishop, int sq) const {
+        return masks[ItemIndex<G>(isBishop, sq)];
     }
-    
-    return attacks;
-}
 
-// Magic output structure
-struct MagicOutput {
-    magicNumber number;
-    int shift;
-    int tableSize;
-    MagicOutput() : number(0), shift(64), tableSize(0) {}
+    BlockerArray<Word> Blockers(bool isBishop, int sq) const {
+        int item = ItemIndex<G>(isBishop, sq);
+        return {blockers.data() + offsets[item], references.data() + offsets[item],
+                offsets[item + 1] - offsets[item]};
+    }
 };
 
-bitboard BishopMasks[64];
-bitboard RookMasks[64];
-
-using BlockerArray = vector<bitboard>;
+template<class G> typename G::Word GenerateAttacks(bool isBishop, int sq, typename G::Word blockers) {
+    return isBishop ? GenerateBishopAttacksOn<G>(sq, blockers)
+                    : GenerateRookAttacksOn<G>(sq, blockers);
+}
 
-bool ValidateMagic(int sq, const MagicOutput& magic, bool isBishop, const BlockerArray &blockers) {
-    vector<bitboard> table(magic.tableSize, 0);
-    for (bitboard b : blockers) {
-        size_t index = (b * magic.number) >> magic.shift;
-        bitboard attacks = isBishop ? GenerateBishopAttacks(sq, b)
-                                    : GenerateRookAttacks(sq, b);
+template<class G>
+bool ValidateMagic(int sq, const MagicOutput& magic, bool isBishop, const BlockerArray<typename G::Word> &blockers) {
+    using Word = typename G::Word;
+    vector<Word> table(magic.tableSize, 0);
+    for (Word b : blockers) {
+        size_t index = MagicHash(b, magic.number) >> magic.shift;
+        Word attacks = GenerateAttacks<G>(isBishop, sq, b);
         if (table[index] != 0 && table[index] != attacks) return false;
         table[index] = attacks;
     }
@@ -171,9 +101,9 @@ bool ValidateMagic(int sq, const MagicOutput& magic, bool isBishop, const Blocke
 }
 
 // Utility functions
-vector<int> GetSetBitIndices(bitboard num) {
+template<class Word> vector<int> GetSetBitIndices(Word num) {
     vector<int> indices;
-    for (int i = 0; i < 64; i++)
+    for (int i = 0; i < int(sizeof(Word) * 8); i++)
         if (IsBitSet(num, i)) indices.push_back(i);
     return indices;
 }
@@ -188,13 +118,60 @@ uint64_t RandomSparseNumber() {
     return RandomNumber() & RandomNumber() & RandomNumber();
 }
 
+// How random candidates are drawn: the AND of three random words (about 8 set
+// bits, the default), of two words (about 16), or one plain random word
+enum class CandidateGenerator { Sparse3, Sparse2, Uniform };
+
+const CandidateGenerator AllGenerators[] = {CandidateGenerator::Sparse3, CandidateGenerator::Sparse2,
+                                            CandidateGenerator::Uniform};
+
+bool ParseGenerator(const string &name, CandidateGenerator &generator) {
+    if (name == "sparse3") generator = CandidateGenerator::Sparse3;
+    else if (name == "sparse2") generator = CandidateGenerator::Sparse2;
+    else if (name == "uniform") generator = CandidateGenerator::Uniform;
+    else return false;
+    return true;
+}
+
+const char *GeneratorName(CandidateGenerator generator) {
+    switch (generator) {
+        case CandidateGenerator::Sparse3: return "sparse3";
+        case CandidateGenerator::Sparse2: return "sparse2";
+        case CandidateGenerator::Uniform: return "uniform";
+    }
+    return "?";
+}
+
+uint64_t RandomCandidate(CandidateGenerator generator) {
+    switch (generator) {
+        case CandidateGenerator::Sparse3: return RandomSparseNumber();
+        case CandidateGenerator::Sparse2: return RandomNumber() & RandomNumber();
+        case CandidateGenerator::Uniform: return RandomNumber();
+    }
+    return 0;
+}
+
 // Global variables
 mutex bestMutex;
-vector<MagicOutput> best(64);
+vector<MagicOutput> best;   // indexed by ItemIndex, sized by RunSearch
+vector<WorkItem> workItems;
 atomic<bool> stopThreads(false);
 atomic<int> squaresFound(0);
+// --database: every valid magic found goes into a bounded pool per (piece, square, shift)
+bool collectMagics = false;
+string databasePath;
+MagicDatabase database;
+atomic<int> poolsFilled(0);
+// --give-up-after: items abandoned after that many candidates without a hit
+int64_t giveUpAfter = 0;
+int workerCount = 1;
+atomic<int> itemsAbandoned(0);
+vector<bool> abandoned;     // indexed by ItemIndex, guarded by bestMutex
+// Items the workers skip without taking the lock: solved (with a full pool when
+// collecting) or abandoned. Indexed by ItemIndex, only set under bestMutex.
+unique_ptr<atomic<bool>[]> settled;
 
-void FillBlockerIndexArray(bitboard mask, BlockerArray &array) {
+template<class Word> void FillBlockerIndexArray(Word mask, vector<Word> &array) {
     vector<int> bits = GetSetBitIndices(mask);
     int n = bits.size();
     int subsetCount = 1 << n;
@@ -202,7 +179,7 @@ void FillBlockerIndexArray(bitboard mask, BlockerArray &array) {
     array.reserve(subsetCount);
     
     for (int subset = 0; subset < subsetCount; subset++) {
-        bitboard blockers = 0;
+        Word blockers = 0;
         for (int j = 0; j < n; j++)
             if (subset & (1 << j))
                 SetBit(blockers, bits[j]);
@@ -210,15 +187,18 @@ void FillBlockerIndexArray(bitboard mask, BlockerArray &array) {
     }
 }
 
-MagicOutput TryMagic(bitboard mask, magicNumber candidate, const BlockerArray &blockers, bool isBishop, int sq) {
-    vector<int> bits = GetSetBitIndices(mask);
-    int relevantBits = bits.size();
-    vector<bitboard> table(1 << relevantBits, 0);
+// Check a candidate against every blocker subset using the shared reference attacks;
+// relevantBits is the target index size (mask bits minus any --shrink)
+template<class G>
+MagicOutput TryMagic(int relevantBits, magicNumber candidate, const BlockerArray<typename G::Word> &blockers) {
+    using Word = typename G::Word;
+    // Per-thread scratch, first touched (and so placed) on the worker's own node
+    thread_local vector<Word> table;
+    table.assign(1 << relevantBits, 0);
 
-    for (bitboard b : blockers) {
-        bitboard attacks = isBishop ? GenerateBishopAttacks(sq, b)
-                                    : GenerateRookAttacks(sq, b);
-        int index = (int)((b * candidate) >> (64 - relevantBits));
+    for (size_t i = 0; i < blockers.size(); i++) {
+        Word attacks = blockers.references[i];
+        int index = (int)(MagicHash(blockers.first[i], candidate) >> (64 - relevantBits));
         if (table[index] == 0)
             table[index] = attacks;
         else if (table[index] != attacks)
@@ -232,38 +212,206 @@ MagicOutput TryMagic(bitboard mask, magicNumber candidate, const BlockerArray &b
     return result;
 }
 
-// Worker thread
-void Worker(int id, bool bishopMode, const vector<bitboard>& masks, const vector<BlockerArray>& blockers) {
+// Collision kernel for a fixed mask size and target shift: the loop count, the
+// shift and the stack scratch table are compile-time constants. Most candidates
+// collide within a few subsets, so instead of clearing the whole table only a
+// bitmap of used slots is cleared (512 bytes for a 4096-slot rook table).
+template<class G, int MaskBits, int Shift>
+bool FitsFixed(magicNumber candidate, const BlockerArray<typename G::Word> &blockers, int) {
+    using Word = typename G::Word;
+    constexpr size_t Count = size_t(1) << MaskBits;
+    constexpr size_t Slots = size_t(1) << (64 - Shift);
+    Word table[Slots];
+    uint64_t used[(Slots + 63) / 64] = {};
+    const Word *first = blockers.first, *references = blockers.references;
+    for (size_t i = 0; i < Count; i++) {
+        size_t index = MagicHash(first[i], candidate) >> Shift;
+        uint64_t bit = uint64_t(1) << (index & 63);
+        if (!(used[index >> 6] & bit)) {
+            used[index >> 6] |= bit;
+            table[index] = references[i];
+        } else if (table[index] != references[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<class G>
+bool FitsGeneric(magicNumber candidate, const BlockerArray<typename G::Word> &blockers, int indexBits) {
+    return TryMagic<G>(indexBits, candidate, blockers).shift < 64;
+}
+
+// The collision check picked for one work item; chosen once per square, not per candidate
+template<class G> struct CollisionKernel {
+    using Function = bool (*)(magicNumber, const BlockerArray<typename G::Word> &, int);
+    Function fits;
+    int indexBits;
+    bool fixed;
+
+    MagicOutput operator()(magicNumber candidate, const BlockerArray<typename G::Word> &blockers) const {
+        MagicOutput result;
+        if (fits(candidate, blockers, indexBits)) {
+            result.number = candidate;
+            result.shift = 64 - indexBits;
+            result.tableSize = 1 << indexBits;
+        }
+        return result;
+    }
+};
+
+// Fixed kernels exist for the full index size and for up to two bits of --shrink
+template<class G, int MaskBits> typename CollisionKernel<G>::Function FixedKernelFor(int indexBits) {
+    switch (MaskBits - indexBits) {
+        case 0: return FitsFixed<G, MaskBits, 64 - MaskBits>;
+        case 1: return FitsFixed<G, MaskBits, 65 - MaskBits>;
+        case 2: return FitsFixed<G, MaskBits, 66 - MaskBits>;
+    }
+    return nullptr;
+}
+
+// Mask sizes 5-12 cover every 8x8 square; anything else uses the generic kernel
+template<class G> CollisionKernel<G> SelectKernel(int maskBits, int indexBits, bool allowFixed) {
+    typename CollisionKernel<G>::Function fits = nullptr;
+    if (allowFixed) {
+        switch (maskBits) {
+            case 5: fits = FixedKernelFor<G, 5>(indexBits); break;
+            case 6: fits = FixedKernelFor<G, 6>(indexBits); break;
+            case 7: fits = FixedKernelFor<G, 7>(indexBits); break;
+            case 8: fits = FixedKernelFor<G, 8>(indexBits); break;
+            case 9: fits = FixedKernelFor<G, 9>(indexBits); break;
+            case 10: fits = FixedKernelFor<G, 10>(indexBits); break;
+            case 11: fits = FixedKernelFor<G, 11>(indexBits); break;
+            case 12: fits = FixedKernelFor<G, 12>(indexBits); break;
+        }
+    }
+    return {fits ? fits : FitsGeneric<G>, indexBits, fits != nullptr};
+}
+
+// Lower bound on index bits: every distinct attack set needs a slot of its own, so
+// subsets with different attack sets must land in different slots at any shift
+struct IndexBound {
+    size_t distinct;
+    int minBits;
+};
+
+template<class Word> IndexBound ComputeIndexBound(const BlockerArray<Word> &blockers) {
+    vector<Word> sets(blockers.references, blockers.references + blockers.size());
+    sort(sets.begin(), sets.end());
+    size_t distinct = unique(sets.begin(), sets.end()) - sets.begin();
+    int minBits = 0;
+    while ((size_t(1) << minBits) < distinct) minBits++;
+    return {distinct, minBits};
+}
+
+// Build the search tables for one NUMA node; called from a thread running on that node
+template<class G> unique_ptr<SearchTables<G>> BuildSearchTables(int node) {
+    const int itemCount = 2 * G::Squares;
+    auto tables = make_unique<SearchTables<G>>();
+    vector<vector<typename G::Word>> subsets(itemCount);
+    tables->offsets[0] = 0;
+    for (int item = 0; item < itemCount; item++) {
+        int sq = item % G::Squares;
+        tables->masks[item] = item >= G::Squares ? GenerateBishopMask<G>(sq)
+                                                 : GenerateRookMask<G>(sq);
+        FillBlockerIndexArray(tables->masks[item], subsets[item]);
+        tables->offsets[item + 1] = tables->offsets[item] + subsets[item].size();
+    }
+
+    tables->blockers.Allocate(tables->offsets[itemCount], node);
+    tables->references.Allocate(tables->offsets[itemCount], node);
+    for (int item = 0; item < itemCount; item++) {
+        size_t offset = tables->offsets[item];
+        copy(subsets[item].begin(), subsets[item].end(), tables->blockers.data() + offset);
+        for (size_t i = 0; i < subsets[item].size(); i++)
+            tables->references[offset + i] = GenerateAttacks<G>(item >= G::Squares, item % G::Squares, subsets[item][i]);
+    }
+    return tables;
+}
+
+// Name of the mode / pieces being searched, for status output
+string ModeName(bool rooks, bool bishops) {
+    return rooks && bishops ? "Rook+Bishop" : bishops ? "Bishop" : "Rook";
+}
+
+// Items the workers no longer visit: solved (with a full pool when collecting) or abandoned
+int ItemsSettled() {
+    return (collectMagics ? poolsFilled.load() : squaresFound.load()) + itemsAbandoned;
+}
+
+// Worker thread; cpu < 0 leaves placement to the OS scheduler
+template<class G> void Worker(int id, int cpu, NodeLocal<SearchTables<G>> &searchTables,
+                              const vector<CollisionKernel<G>> &kernels, CandidateGenerator generator) {
+    // Pin before touching any tables so the node-local copy is the right one
+    if (cpu >= 0) PinCurrentThread(cpu);
+    const SearchTables<G> &tables = searchTables.Local();
     auto lastDump = steady_clock::now();
     int attempts = 0;
     
+    int itemCount = workItems.size();
+    // This thread's candidates per item; all threads sweep every item, so the
+    // total is about workerCount times this
+    vector<int64_t> itemAttempts(itemCount, 0);
+    
+    // All threads share one pool of (piece, square) items: once the cheap bishop
+    // squares are solved every thread's sweep only visits the remaining rook squares
     while (!stopThreads) {
-        for (int sq = 0; sq < 64 && !stopThreads; sq++) {
-            // Skip if already found
-            {
+        for (int i = 0; i < itemCount && !stopThreads; i++) {
+            int workIndex = (i + id) % itemCount;
+            const WorkItem &work = workItems[workIndex];
+            int item = ItemIndex<G>(work.isBishop, work.sq);
+            // Skip if already found (and, when collecting, its pool is full) or given up on
+            if (settled[item]) continue;
+            if (giveUpAfter > 0 && itemAttempts[workIndex] * workerCount >= giveUpAfter) {
                 lock_guard<mutex> lock(bestMutex);
-                if (best[sq].shift < 64) continue;
+                if (settled[item]) continue;
+                abandoned[item] = true;
+                settled[item] = true;
+                itemsAbandoned++;
+                cout << "Giving up on " << (work.isBishop ? "bishop" : "rook") << " square " << work.sq
+                     << " at " << work.indexBits << " index bits\n";
+                if (ItemsSettled() >= itemCount) stopThreads = true;
+                continue;
             }
+            itemAttempts[workIndex]++;
             
             attempts++;
             
             // Generate candidate with sparse bits
-            uint64_t candidate = RandomSparseNumber();
+            uint64_t candidate = RandomCandidate(generator);
             
-            MagicOutput attempt = TryMagic(masks[sq], candidate, blockers[sq], bishopMode, sq);
+            BlockerArray<typename G::Word> blockers = tables.Blockers(work.isBishop, work.sq);
+            MagicOutput attempt = kernels[workIndex](candidate, blockers);
             
             if (attempt.shift < 64) {
-                if(ValidateMagic(sq, attempt, bishopMode, blockers[sq])){
+                if(ValidateMagic<G>(work.sq, attempt, work.isBishop, blockers)){
+                    // Annotating walks every blocker subset, so do it before taking the lock
+                    MagicRecord record;
+                    if (collectMagics)
+                        record = AnnotateMagic(work.isBishop, work.sq, attempt.number, attempt.shift,
+                                               blockers.first, blockers.size());
                     lock_guard<mutex> lock(bestMutex);
-                    if (best[sq].shift == 64) {
-                        best[sq] = attempt;
+                    // Another thread gave up on the item while this candidate was tested;
+                    // it already counts as settled, so counting the hit would overshoot
+                    if (abandoned[item]) continue;
+                    if (best[item].shift == 64) {
+                        best[item] = attempt;
                         squaresFound++;
-                        
-                        // Check if all squares are found
-                        if (squaresFound == 64) {
-                            stopThreads = true;
+                        if (!collectMagics) settled[item] = true;
+                    }
+                    if (collectMagics) {
+                        size_t before = database.PoolSize(work.isBishop, work.sq, attempt.shift);
+                        database.Add(record);
+                        if (before < database.Capacity() && database.PoolSize(work.isBishop, work.sq, attempt.shift) >= database.Capacity()) {
+                            poolsFilled++;
+                            settled[item] = true;
                         }
                     }
+
+                    // Check if all squares are found (or given up on)
+                    if (ItemsSettled() >= itemCount) {
+                        stopThreads = true;
+                    }
                 }
             }
         }
@@ -271,65 +419,696 @@ void Worker(int id, bool bishopMode, const vector<bitboard>& masks, const vector
         // Print status every 5 seconds
         auto now = steady_clock::now();
         if (duration_cast<seconds>(now - lastDump).count() >= 5) {
-            lock_guard<mutex> lock(bestMutex);
-            cout << "\n=== Current Best " << (bishopMode ? "Bishop" : "Rook") << " Magics ===\n";
-            cout << "Squares found: " << squaresFound << "/64\n";
-            cout << "Thread " << id << " attempts: " << attempts << "\n";
+            // Keep the database file current in case the search is interrupted; the copy
+            // is taken under the lock and written after releasing it
+            unique_ptr<MagicDatabase> snapshot;
+            {
+                lock_guard<mutex> lock(bestMutex);
+                bool rooks = !workItems.front().isBishop, bishops = workItems.back().isBishop;
+                cout << "\n=== Current Best " << ModeName(rooks, bishops) << " Magics ===\n";
+                cout << "Squares found: " << squaresFound << "/" << itemCount << "\n";
+                if (itemsAbandoned > 0) cout << "Squares given up on: " << itemsAbandoned << "\n";
+                if (collectMagics) {
+                    cout << "Magic pools full: " << poolsFilled << "/" << itemCount
+                         << ", " << database.RecordCount() << " magics collected\n";
+                    if (id == 0) snapshot = make_unique<MagicDatabase>(database);
+                }
+                cout << "Thread " << id << " attempts: " << attempts << "\n";
+            }
+            if (snapshot) snapshot->Save(databasePath);
             
             lastDump = now;
         }
     }
 }
 
-// Main function
-int main(int argc, char** argv) {
-    bool bishopMode = false;
-    if (argc > 1 && string(argv[1]) == "--bishop") 
-        bishopMode = true;
+// Total candidates/sec of `threadCount` pinned threads trying random magics for a short while
+template<class G>
+double MeasureCandidateRate(const vector<int> &cpuOrder, int threadCount,
+                            NodeLocal<SearchTables<G>> &searchTables,
+                            const vector<CollisionKernel<G>> &kernels, CandidateGenerator generator,
+                            milliseconds period) {
+    atomic<bool> stop(false);
+    atomic<long long> total(0);
+    vector<thread> threads;
+    for (int i = 0; i < threadCount; i++) {
+        threads.emplace_back([&, i] {
+            PinCurrentThread(cpuOrder[i % cpuOrder.size()]);
+            const SearchTables<G> &tables = searchTables.Local();
+            long long attempts = 0;
+            for (size_t k = i; !stop; k++, attempts++) {
+                const WorkItem &work = workItems[k % workItems.size()];
+                kernels[k % workItems.size()](RandomCandidate(generator), tables.Blockers(work.isBishop, work.sq));
+            }
+            total += attempts;
+        });
+    }
+    this_thread::sleep_for(period);
+    stop = true;
+    for (auto &t : threads)
+        t.join();
+    return total / duration<double>(period).count();
+}
 
-    // Precompute masks and blockers
-    vector<bitboard> masks(64);
-    vector<BlockerArray> blockers(64);
-    
-    for (int sq = 0; sq < 64; sq++) {
-        masks[sq] = bishopMode ? GenerateBishopMovesMaskAtSquare(sq) 
-                               : GenerateRookMovesMaskAtSquare(sq);
-        FillBlockerIndexArray(masks[sq], blockers[sq]);
-        
-        vector<int> bits = GetSetBitIndices(masks[sq]);
-        cout << "Square " << sq << " mask has " << bits.size() << " bits\n";
+void PrintUsage(const char *program) {
+    cout << "Usage: " << program << " [--bishop | --both] [--board 8x8|10x8|10x10] [--threads N]\n"
+         << "       [--affinity auto|none|compact|scatter|physical] [--shrink N]\n"
+         << "       [--engine random|constructive] [--max-magic-bits K] [--node-budget N]\n"
+         << "       [--kernel fixed|generic] [--generator sparse3|sparse2|uniform]\n"
+         << "       [--benchmark [--seeds N] [--time-cap S] [--bench-squares LIST]\n"
+         << "                    [--bench-shrink LIST] [--bench-threads LIST]]\n"
+         << "       [--database FILE [--pool-size N]] [--list-database FILE]\n"
+         << "       [--bound-margin N] [--give-up-after N] [--bounds]\n"
+         << "  --bishop        search bishop magics instead of rook magics\n"
+         << "  --both          search rook and bishop magics together in one worker pool\n"
+         << "  --board G       board geometry; 10x8 and 10x10 use 128-bit boards\n"
+         << "  --threads N     number of worker threads (default: all logical cpus, or all\n"
+         << "                  physical cores with --affinity physical)\n"
+         << "  --affinity P    how workers are pinned to cpus; auto calibrates whether SMT\n"
+         << "                  siblings help and picks scatter or physical\n"
+         << "  --shrink N      look for magics with N fewer index bits than mask bits\n"
+         << "  --engine E      random guessing (default) or constructive bit-by-bit search\n"
+         << "                  (8x8 only), which can also prove that no magic exists\n"
+         << "  --max-magic-bits K  constructive: only magics with at most K set bits (default 7)\n"
+         << "  --node-budget N     constructive: search nodes allowed per square (default 1e8)\n"
+         << "  --kernel K      random: fixed (default) uses collision checks specialised per mask\n"
+         << "                  size and shift where available, generic always uses the runtime one\n"
+         << "  --generator G   random candidates: AND of 3 random words (default), of 2, or uniform\n"
+         << "  --benchmark     time seeded searches instead of searching: median and p90\n"
+         << "                  time-to-first-hit, candidates/s and hit rate per kernel,\n"
+         << "                  generator and thread count (all kernels/generators unless given)\n"
+         << "  --seeds N       benchmark seeds 1..N (default 5)\n"
+         << "  --time-cap S    seconds before a benchmark trial gives up (default 2)\n"
+         << "  --bench-squares LIST  items such as ra1,bd4 (default ra1,rd4,bc1,bd4)\n"
+         << "  --bench-shrink LIST   target shrinks per item (default 0)\n"
+         << "  --bench-threads LIST  thread counts (default 1 and all logical cpus)\n"
+         << "  --database FILE keep searching after the first hit and collect up to --pool-size\n"
+         << "                  distinct magics per square and shift (default 64) into FILE,\n"
+         << "                  with max index, empty slots and constructive collisions of each\n"
+         << "  --list-database FILE  print the magics stored in FILE and exit\n"
+         << "  --bound-margin N  skip targets less than N bits above the index-bit bound\n"
+         << "                  (distinct attack sets need distinct slots); impossible\n"
+         << "                  targets below the bound are always skipped\n"
+         << "  --give-up-after N  random: abandon a square after about N candidates\n"
+         << "  --bounds        print each square's index-bit bound and exit\n";
+}
+
+// Command line settings shared by every board geometry
+struct SearchOptions {
+    bool searchRooks = true, searchBishops = false;
+    int threadCount = 0;
+    AffinityPolicy policy = AffinityPolicy::Auto;
+    int shrink = 0;
+    bool constructive = false;
+    int maxMagicBits = 7;
+    int64_t nodeBudget = 100000000;
+    bool fixedKernels = true;
+    CandidateGenerator generator = CandidateGenerator::Sparse3;
+
+    // --benchmark: every kernel and generator unless one was given explicitly
+    bool benchmark = false;
+    bool kernelGiven = false, generatorGiven = false;
+    int benchSeeds = 5;
+    double timeCap = 2.0;
+    string benchSquares = "ra1,rd4,bc1,bd4";
+    vector<int> benchShrinks = {0};
+    vector<int> benchThreads;
+
+    // Index-bit bound: skip targets within boundMargin bits of it, give up on an
+    // item after giveUpAfter candidates (0: never), or only print the bounds
+    int boundMargin = 0;
+    int64_t giveUpAfter = 0;
+    bool boundsOnly = false;
+
+    // --database: collect up to poolSize valid magics per (piece, square, shift) into a file
+    string databasePath;
+    size_t poolSize = 64;
+    string listDatabase;
+};
+
+// Parse "1,2,4" into numbers; false on anything else
+bool ParseIntList(const string &text, vector<int> &values) {
+    values.clear();
+    size_t pos = 0;
+    while (pos <= text.size()) {
+        size_t end = text.find(',', pos);
+        if (end == string::npos) end = text.size();
+        string item = text.substr(pos, end - pos);
+        if (item.empty() || item.find_first_not_of("0123456789") != string::npos) return false;
+        values.push_back(atoi(item.c_str()));
+        pos = end + 1;
     }
+    return !values.empty();
+}
 
-    int threadCount = thread::hardware_concurrency();
-    cout << "Running in " << (bishopMode ? "bishop" : "rook") 
-         << " mode with " << threadCount << " threads.\n";
+// Parse benchmark items such as "ra1,bd4" (r = rook, b = bishop, then the square name)
+template<class G> bool ParseBenchSquares(const string &text, vector<WorkItem> &items) {
+    items.clear();
+    size_t pos = 0;
+    while (pos <= text.size()) {
+        size_t end = text.find(',', pos);
+        if (end == string::npos) end = text.size();
+        string item = text.substr(pos, end - pos);
+        if (item.size() < 3 || (item[0] != 'r' && item[0] != 'b')) return false;
+        int file = item[1] - 'a', rank = atoi(item.c_str() + 2) - 1;
+        if (file < 0 || file >= G::Files || rank < 0 || rank >= G::Ranks) return false;
+        items.push_back({item[0] == 'b', G::Square(rank, file), 0});
+        pos = end + 1;
+    }
+    return !items.empty();
+}
 
-    vector<thread> threads;
-    for (int i = 0; i < threadCount; i++)
-        threads.emplace_back(Worker, i, bishopMode, ref(masks), ref(blockers));
+// One seeded search of a single item by `threadCount` threads, stopped at the first hit or the time cap
+struct BenchmarkTrial {
+    double seconds;
+    long long candidates;
+    bool found;
+};
 
-    for (auto &t : threads) 
+template<class G>
+BenchmarkTrial RunBenchmarkTrial(const WorkItem &work, const CollisionKernel<G> &kernel, CandidateGenerator generator,
+                                 int threadCount, const vector<int> &cpuOrder,
+                                 NodeLocal<SearchTables<G>> &searchTables, uint64_t seed, double timeCap) {
+    atomic<bool> found(false);
+    atomic<long long> candidates(0);
+    auto start = steady_clock::now();
+    vector<thread> threads;
+    for (int i = 0; i < threadCount; i++) {
+        threads.emplace_back([&, i] {
+            if (!cpuOrder.empty()) PinCurrentThread(cpuOrder[i % cpuOrder.size()]);
+            rng.seed(seed * 1000003 + i);
+            BlockerArray<typename G::Word> blockers = searchTables.Local().Blockers(work.isBishop, work.sq);
+            long long tried = 0;
+            while (!found) {
+                // Check the clock only every few hundred candidates
+                for (int k = 0; k < 256; k++, tried++) {
+                    if (kernel(RandomCandidate(generator), blockers).shift < 64) {
+                        found = true;
+                        break;
+                    }
+                }
+                if (duration<double>(steady_clock::now() - start).count() >= timeCap) break;
+            }
+            candidates += tried;
+        });
+    }
+    for (auto &t : threads)
         t.join();
+    return {duration<double>(steady_clock::now() - start).count(), candidates, found};
+}
+
+// Nearest-rank percentile of an unsorted sample
+double Percentile(vector<double> values, double fraction) {
+    sort(values.begin(), values.end());
+    size_t rank = size_t(ceil(fraction * values.size()));
+    return values[min(values.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+// Time-to-first-hit, candidates/s and hit rate over a fixed set of seeds, for every
+// combination of kernel, generator, thread count, item and target shrink
+template<class G> int RunBenchmark(const SearchOptions &options, const CpuTopology &topology) {
+    vector<WorkItem> items;
+    if (!ParseBenchSquares<G>(options.benchSquares, items)) {
+        cerr << "Bad --bench-squares list: " << options.benchSquares << "\n";
+        return 1;
+    }
+    NodeLocal<SearchTables<G>> searchTables(BuildSearchTables<G>);
+    const SearchTables<G> &mainTables = searchTables.Local();
+
+    AffinityPolicy policy = options.policy == AffinityPolicy::Auto ? AffinityPolicy::Scatter : options.policy;
+    vector<int> cpuOrder;
+    if (policy != AffinityPolicy::None) cpuOrder = PlanCpuOrder(topology, policy);
+    vector<int> threadCounts = options.benchThreads;
+    if (threadCounts.empty()) {
+        threadCounts = {1};
+        if (topology.cpus.size() > 1) threadCounts.push_back(topology.cpus.size());
+    }
+    vector<bool> kernelChoices = {options.fixedKernels};
+    if (!options.kernelGiven) kernelChoices = {true, false};
+    vector<CandidateGenerator> generators = {options.generator};
+    if (!options.generatorGiven) generators.assign(begin(AllGenerators), end(AllGenerators));
+
+    cout << "Benchmark: " << options.benchSeeds << " seeds, time cap " << options.timeCap
+         << " s per trial, affinity " << AffinityPolicyName(policy) << "\n";
+    cout << left << setw(8) << "kernel" << setw(9) << "gen" << right << setw(4) << "thr" << "  "
+         << left << setw(9) << "item" << right << setw(5) << "bits" << setw(8) << "solved"
+         << setw(11) << "median s" << setw(11) << "p90 s" << setw(14) << "median cand/s"
+         << setw(12) << "hit rate" << "\n";
+
+    for (bool fixedKernel : kernelChoices) {
+        for (CandidateGenerator generator : generators) {
+            for (int threadCount : threadCounts) {
+                for (WorkItem work : items) {
+                    int maskBits = GetSetBitIndices(mainTables.Mask(work.isBishop, work.sq)).size();
+                    for (int shrink : options.benchShrinks) {
+                        work.indexBits = max(1, maskBits - shrink);
+                        CollisionKernel<G> kernel = SelectKernel<G>(maskBits, work.indexBits, fixedKernel);
+
+                        // Unsolved trials count as the time cap, so the statistics are lower bounds then
+                        vector<double> times, rates;
+                        long long candidates = 0;
+                        int solved = 0;
+                        for (int seed = 1; seed <= options.benchSeeds; seed++) {
+                            BenchmarkTrial trial = RunBenchmarkTrial<G>(work, kernel, generator, threadCount,
+                                                                        cpuOrder, searchTables, seed, options.timeCap);
+                            times.push_back(trial.seconds);
+                            rates.push_back(trial.candidates / max(trial.seconds, 1e-9));
+                            candidates += trial.candidates;
+                            solved += trial.found;
+                        }
+
+                        string name = string(work.isBishop ? "b" : "r") + char('a' + G::File(work.sq)) +
+                                      to_string(G::Rank(work.sq) + 1);
+                        streamsize precision = cout.precision();
+                        cout << left << setw(8) << (kernel.fixed ? "fixed" : "generic") << setw(9)
+                             << GeneratorName(generator) << right << setw(4) << threadCount << "  "
+                             << left << setw(9) << name << right << setw(5) << work.indexBits
+                             << setw(5) << solved << "/" << left << setw(2) << options.benchSeeds << right
+                             << fixed << setprecision(4) << setw(11) << Percentile(times, 0.5)
+                             << setw(11) << Percentile(times, 0.9)
+                             << setprecision(0) << setw(14) << Percentile(rates, 0.5)
+                             << scientific << setprecision(2) << setw(12) << double(solved) / max(1LL, candidates)
+                             << "\n";
+                        cout.unsetf(ios::floatfield);
+                        cout.precision(precision);
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+// Constructive engine: squares are solved one after another, and all threads
+// split each square's search tree by taking magic prefixes from a shared queue
+template<class G> void RunConstructiveSearch(const vector<int> &cpuOrder, int threadCount,
+                                             NodeLocal<SearchTables<G>> &searchTables,
+                                             const SearchOptions &options) {
+    if constexpr (!is_same<typename G::Word, uint64_t>::value) {
+        cerr << "The constructive engine only supports 64-bit boards\n";
+    } else {
+        // Top magic bits fixed per subtree, most set bits first as in the DFS itself
+        const int prefixBits = 6;
+        vector<uint64_t> prefixes;
+        for (int prefix = (1 << prefixBits) - 1; prefix >= 0; prefix--)
+            if (__builtin_popcount(prefix) <= options.maxMagicBits)
+                prefixes.push_back(uint64_t(prefix) << (64 - prefixBits));
+
+        for (const WorkItem &work : workItems) {
+            if (stopThreads) break;
+            // Already solved, e.g. preloaded from a full --database pool
+            if (best[ItemIndex<G>(work.isBishop, work.sq)].shift < 64) continue;
+            atomic<size_t> nextPrefix(0);
+            atomic<bool> found(false);
+            atomic<int64_t> budget(options.nodeBudget), nodes(0);
+            atomic<size_t> exhausted(0);
+            uint64_t magic = 0;
+            mutex foundMutex;
 
-    // Final output
-    cout << "\n=== Final " << (bishopMode ? "Bishop" : "Rook") << " Magics ===\n";
-    for (int sq = 0; sq < 64; sq++) {
-        auto &m = best[sq];
-        cout << "Square " << sq << ": Magic=0x" << hex << setw(16) << setfill('0') << m.number << dec
-             << " Shift=" << m.shift
-             << " TableSize=" << m.tableSize << "\n";
+            vector<thread> threads;
+            for (int i = 0; i < threadCount; i++) {
+                threads.emplace_back([&, i] {
+                    if (!cpuOrder.empty()) PinCurrentThread(cpuOrder[i % cpuOrder.size()]);
+                    BlockerArray<uint64_t> blockers = searchTables.Local().Blockers(work.isBishop, work.sq);
+                    ConstructiveMagicSearch search(blockers.first, blockers.references, blockers.size(),
+                                                   work.indexBits, options.maxMagicBits);
+                    while (!found) {
+                        size_t k = nextPrefix++;
+                        if (k >= prefixes.size()) break;
+                        auto status = search.SearchPrefix(prefixes[k], prefixBits, budget, found);
+                        if (status == ConstructiveMagicSearch::Found) {
+                            lock_guard<mutex> lock(foundMutex);
+                            if (!found) magic = search.Magic();
+                            found = true;
+                        } else if (status == ConstructiveMagicSearch::Exhausted) {
+                            exhausted++;
+                        }
+                    }
+                    nodes += search.Nodes();
+                });
+            }
+            for (auto &t : threads)
+                t.join();
+
+            cout << (work.isBishop ? "Bishop" : "Rook") << " square " << work.sq
+                 << " (" << work.indexBits << " bits): ";
+            if (found) {
+                MagicOutput result;
+                result.number = magic;
+                result.shift = 64 - work.indexBits;
+                result.tableSize = 1 << work.indexBits;
+                if (ValidateMagic<G>(work.sq, result, work.isBishop, searchTables.Local().Blockers(work.isBishop, work.sq))) {
+                    best[ItemIndex<G>(work.isBishop, work.sq)] = result;
+                    squaresFound++;
+                    if (collectMagics) {
+                        BlockerArray<uint64_t> blockers = searchTables.Local().Blockers(work.isBishop, work.sq);
+                        database.Add(AnnotateMagic(work.isBishop, work.sq, magic, result.shift,
+                                                   blockers.first, blockers.size()));
+                    }
+                    cout << "found 0x" << hex << setw(16) << setfill('0') << magic << dec << setfill(' ');
+                } else {
+                    cout << "0x" << hex << setw(16) << setfill('0') << magic << dec << setfill(' ') << " failed validation";
+                }
+            } else if (exhausted == prefixes.size()) {
+                cout << "proved no magic with <= " << options.maxMagicBits << " set bits exists";
+            } else {
+                cout << "node budget exhausted";
+            }
+            cout << " after " << nodes << " nodes\n";
+        }
+    }
+}
+
+// --bounds: distinct attack sets and the index-bit bound of every square, next to
+// the mask size and (on 8x8) the library magics
+template<class G> int PrintIndexBounds(const SearchOptions &options) {
+    unique_ptr<SearchTables<G>> tables = BuildSearchTables<G>(-1);
+    for (bool isBishop : {false, true}) {
+        if (isBishop ? !options.searchBishops : !options.searchRooks) continue;
+        cout << "\n=== " << (isBishop ? "Bishop" : "Rook") << " index-bit bounds ===\n";
+        for (int sq = 0; sq < G::Squares; sq++) {
+            IndexBound bound = ComputeIndexBound(tables->Blockers(isBishop, sq));
+            int maskBits = GetSetBitIndices(tables->Mask(isBishop, sq)).size();
+            cout << "Square " << sq << ": mask " << maskBits << " bits, " << bound.distinct
+                 << " distinct attack sets, bound " << bound.minBits << " bits";
+            if constexpr (is_same<G, Chess8x8>::value) {
+                int libraryBits = 64 - (isBishop ? BishopMagics[sq] : RookMagics[sq]).shift;
+                cout << ", library magic " << libraryBits << " bits (+" << libraryBits - bound.minBits << ")";
+            }
+            cout << "\n";
+        }
+    }
+    return 0;
+}
+
+// --list-database: every pool of a magic database, best magic first
+template<class G> int ListDatabase(const SearchOptions &options) {
+    MagicDatabase db(G::Files, G::Ranks, SIZE_MAX);
+    if (!db.Load(options.listDatabase)) {
+        cerr << "Could not read " << options.listDatabase << " as a " << G::Files << "x" << G::Ranks
+             << " magic database\n";
+        return 1;
+    }
+    cout << db.RecordCount() << " magics in " << options.listDatabase << "\n";
+    for (bool isBishop : {false, true}) {
+        for (int sq = 0; sq < G::Squares; sq++) {
+            for (int shift : db.Shifts(isBishop, sq)) {
+                const vector<MagicRecord> &pool = db.Query(isBishop, sq, shift);
+                cout << (isBishop ? "Bishop" : "Rook") << " square " << sq << ", " << 64 - shift
+                     << " index bits: " << pool.size() << " magics\n";
+                for (const MagicRecord &record : pool)
+                    cout << "    0x" << hex << setw(16) << setfill('0') << record.magic << dec << setfill(' ')
+                         << "  max index " << record.maxIndex << "/" << record.TableSize() - 1
+                         << "  empty slots " << record.EmptyCount()
+                         << "  constructive collisions " << record.constructiveCollisions << "\n";
+            }
+        }
     }
+    return 0;
+}
+
+template<class G> int RunSearch(SearchOptions options, const CpuTopology &topology) {
+    bool searchRooks = options.searchRooks, searchBishops = options.searchBishops;
+    int threadCount = options.threadCount;
+    AffinityPolicy policy = options.policy;
+    best.assign(2 * G::Squares, MagicOutput());
+    abandoned.assign(2 * G::Squares, false);
+    settled = make_unique<atomic<bool>[]>(2 * G::Squares);
+    giveUpAfter = options.giveUpAfter;
+
+    // Precompute masks and blockers, replicated lazily on every NUMA node a worker runs on
+    NodeLocal<SearchTables<G>> searchTables(BuildSearchTables<G>);
+
+    // Bishop items go first so they are all solved in the first few sweeps. Targets
+    // below the index-bit bound (plus --bound-margin) are not searched at all.
+    const SearchTables<G> &mainTables = searchTables.Local();
+    vector<IndexBound> bounds(2 * G::Squares);
+    int skipped = 0;
+    for (bool isBishop : {true, false}) {
+        if (isBishop ? !searchBishops : !searchRooks) continue;
+        for (int sq = 0; sq < G::Squares; sq++) {
+            int maskBits = GetSetBitIndices(mainTables.Mask(isBishop, sq)).size();
+            int indexBits = max(1, maskBits - options.shrink);
+            IndexBound &bound = bounds[ItemIndex<G>(isBishop, sq)];
+            bound = ComputeIndexBound(mainTables.Blockers(isBishop, sq));
+            if (indexBits < bound.minBits + options.boundMargin) {
+                cout << "Skipping " << (isBishop ? "bishop" : "rook") << " square " << sq << ": " << indexBits
+                     << " index bits " << (indexBits < bound.minBits ? "cannot hold " : "are too close to ")
+                     << bound.distinct << " distinct attack sets (bound " << bound.minBits << " bits)\n";
+                skipped++;
+                continue;
+            }
+            workItems.push_back({isBishop, sq, indexBits});
+        }
+    }
+    if (workItems.empty()) {
+        cerr << "Every target is below the index-bit bound, nothing to search\n";
+        return 1;
+    }
+    
+    vector<CollisionKernel<G>> kernels;
+    for (const WorkItem &work : workItems) {
+        int maskBits = GetSetBitIndices(mainTables.Mask(work.isBishop, work.sq)).size();
+        kernels.push_back(SelectKernel<G>(maskBits, work.indexBits, options.fixedKernels));
+    }
+    if (!options.databasePath.empty()) {
+        collectMagics = true;
+        databasePath = options.databasePath;
+        database = MagicDatabase(G::Files, G::Ranks, options.poolSize);
+        // Keep adding to an existing file; its full pools count towards the stop condition
+        if (database.Load(databasePath))
+            cout << "Loaded " << database.RecordCount() << " magics from " << databasePath << "\n";
+        // Squares whose pool is already full start out solved with the pool's best magic
+        for (const WorkItem &work : workItems) {
+            const vector<MagicRecord> &pool = database.Query(work.isBishop, work.sq, 64 - work.indexBits);
+            if (pool.size() < database.Capacity()) continue;
+            MagicOutput &solved = best[ItemIndex<G>(work.isBishop, work.sq)];
+            solved.number = pool[0].magic;
+            solved.shift = pool[0].shift;
+            solved.tableSize = int(pool[0].TableSize());
+            squaresFound++;
+            poolsFilled++;
+            settled[ItemIndex<G>(work.isBishop, work.sq)] = true;
+        }
+    }
+
+    cout << count_if(kernels.begin(), kernels.end(), [](const CollisionKernel<G> &k) { return k.fixed; })
+         << "/" << kernels.size() << " squares use fixed-size collision kernels\n";
     
+    for (const WorkItem &work : workItems) {
+        vector<int> bits = GetSetBitIndices(mainTables.Mask(work.isBishop, work.sq));
+        cout << (searchRooks && searchBishops ? (work.isBishop ? "Bishop square " : "Rook square ") : "Square ")
+             << work.sq << " mask has " << bits.size() << " bits";
+        if (work.indexBits != int(bits.size())) cout << ", target " << work.indexBits << " index bits";
+        cout << ", bound " << bounds[ItemIndex<G>(work.isBishop, work.sq)].minBits << "\n";
+    }
+    cout << "NUMA nodes: " << NumaNodeCount()
+         << ", blocker arena " << (mainTables.blockers.UsesHugeTlb() ? "in hugetlb pages" : "THP-advised") << "\n";
+
+    // Only worth calibrating when SMT exists and the thread count is ours to pick; the
+    // constructive engine does not run the candidate kernels being measured
+    if (policy == AffinityPolicy::Auto) {
+        policy = AffinityPolicy::Scatter;
+        if (topology.HasSmt() && threadCount == 0 && !options.constructive) {
+            const milliseconds calibrationTime(500);
+            vector<int> physicalOrder = PlanCpuOrder(topology, AffinityPolicy::Physical);
+            vector<int> scatterOrder = PlanCpuOrder(topology, AffinityPolicy::Scatter);
+            double physicalRate = MeasureCandidateRate(physicalOrder, physicalOrder.size(),
+                                                       searchTables, kernels, options.generator, calibrationTime);
+            double smtRate = MeasureCandidateRate(scatterOrder, scatterOrder.size(),
+                                                  searchTables, kernels, options.generator, calibrationTime);
+            streamsize precision = cout.precision();
+            cout << fixed << setprecision(0)
+                 << "Calibration: physical cores only " << physicalRate << " candidates/s, "
+                 << "with SMT siblings " << smtRate << " candidates/s\n";
+            cout.unsetf(ios::floatfield);
+            cout.precision(precision);
+            if (physicalRate >= smtRate)
+                policy = AffinityPolicy::Physical;
+        }
+    }
+
+    vector<int> cpuOrder;
+    if (policy != AffinityPolicy::None)
+        cpuOrder = PlanCpuOrder(topology, policy);
+    if (threadCount == 0)
+        threadCount = policy == AffinityPolicy::Physical ? topology.physicalCores
+                                                         : max(1u, thread::hardware_concurrency());
+
+    cout << "Running in " << (searchRooks && searchBishops ? "rook+bishop" : searchBishops ? "bishop" : "rook")
+         << " mode on a " << G::Files << "x" << G::Ranks << " board"
+         << " with " << threadCount << " threads, affinity " << AffinityPolicyName(policy) << ".\n";
+
+    workerCount = threadCount;
+    if (ItemsSettled() >= int(workItems.size())) stopThreads = true;
+    if (options.constructive) {
+        RunConstructiveSearch<G>(cpuOrder, threadCount, searchTables, options);
+    } else {
+        vector<thread> threads;
+        for (int i = 0; i < threadCount; i++) {
+            int cpu = cpuOrder.empty() ? -1 : cpuOrder[i % cpuOrder.size()];
+            threads.emplace_back(Worker<G>, i, cpu, ref(searchTables), cref(kernels), options.generator);
+        }
+
+        for (auto &t : threads) 
+            t.join();
+    }
+
+    // Final output: one section per searched piece, in a single combined listing
+    for (bool isBishop : {false, true}) {
+        if (isBishop ? !searchBishops : !searchRooks) continue;
+        cout << "\n=== Final " << (isBishop ? "Bishop" : "Rook") << " Magics ===\n";
+        for (int sq = 0; sq < G::Squares; sq++) {
+            auto &m = best[ItemIndex<G>(isBishop, sq)];
+            const IndexBound &bound = bounds[ItemIndex<G>(isBishop, sq)];
+            cout << "Square " << sq << ": Magic=0x" << hex << setw(16) << setfill('0') << m.number << dec << setfill(' ')
+                 << " Shift=" << m.shift
+                 << " TableSize=" << m.tableSize;
+            // How many index bits the magic is above the bound, i.e. the room left for shrinking
+            if (m.shift < 64) cout << " Bound=" << bound.minBits << " (+" << 64 - m.shift - bound.minBits << ")";
+            cout << "\n";
+        }
+    }
+    
+    if (collectMagics) {
+        if (database.Save(databasePath))
+            cout << "\nSaved " << database.RecordCount() << " magics to " << databasePath << "\n";
+        else
+            cerr << "Could not write " << databasePath << "\n";
+    }
+
     // Output in array format for easy copying
     cout << "\nArray format:\n";
-    cout << "const Magic " << (bishopMode ? "BishopMagics" : "RookMagics") << "[64] = {\n";
-    for (int sq = 0; sq < 64; sq++) {
-        auto &m = best[sq];
-        cout << "    {0x" << hex << setw(16) << setfill('0') << m.number << ", " << dec << m.shift << ", " << m.tableSize << "}";
-        if (sq < 63) cout << ",";
-        cout << "\n";
+    for (bool isBishop : {false, true}) {
+        if (isBishop ? !searchBishops : !searchRooks) continue;
+        cout << "const Magic " << (isBishop ? "BishopMagics" : "RookMagics") << "[" << G::Squares << "] = {\n";
+        for (int sq = 0; sq < G::Squares; sq++) {
+            auto &m = best[ItemIndex<G>(isBishop, sq)];
+            cout << "    {0x" << hex << setw(16) << setfill('0') << m.number << setfill(' ') << ", " << dec << m.shift << ", " << m.tableSize << "}";
+            if (sq < G::Squares - 1) cout << ",";
+            cout << "\n";
+        }
+        cout << "};\n";
     }
-    cout << "};\n";
 
     return 0;
-}
\ No newline at end of file
+}
+
+// Main function
+int main(int argc, char** argv) {
+    SearchOptions options;
+    string board = "8x8";
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--bishop") {
+            options.searchRooks = false;
+            options.searchBishops = true;
+        } else if (arg == "--both") {
+            options.searchRooks = options.searchBishops = true;
+        } else if (arg == "--shrink" && i + 1 < argc) {
+            options.shrink = atoi(argv[++i]);
+        } else if (arg == "--engine" && i + 1 < argc) {
+            string engine = argv[++i];
+            if (engine != "random" && engine != "constructive") {
+                cerr << "Unknown search engine: " << engine << "\n";
+                return 1;
+            }
+            options.constructive = engine == "constructive";
+        } else if (arg == "--max-magic-bits" && i + 1 < argc) {
+            options.maxMagicBits = atoi(argv[++i]);
+        } else if (arg == "--node-budget" && i + 1 < argc) {
+            options.nodeBudget = atoll(argv[++i]);
+        } else if (arg == "--kernel" && i + 1 < argc) {
+            string kernel = argv[++i];
+            if (kernel != "fixed" && kernel != "generic") {
+                cerr << "Unknown kernel: " << kernel << "\n";
+                return 1;
+            }
+            options.fixedKernels = kernel == "fixed";
+            options.kernelGiven = true;
+        } else if (arg == "--generator" && i + 1 < argc) {
+            if (!ParseGenerator(argv[++i], options.generator)) {
+                cerr << "Unknown candidate generator: " << argv[i] << "\n";
+                return 1;
+            }
+            options.generatorGiven = true;
+        } else if (arg == "--benchmark") {
+            options.benchmark = true;
+        } else if (arg == "--seeds" && i + 1 < argc) {
+            options.benchSeeds = max(1, atoi(argv[++i]));
+        } else if (arg == "--time-cap" && i + 1 < argc) {
+            options.timeCap = atof(argv[++i]);
+        } else if (arg == "--bench-squares" && i + 1 < argc) {
+            options.benchSquares = argv[++i];
+        } else if ((arg == "--bench-shrink" || arg == "--bench-threads") && i + 1 < argc) {
+            vector<int> &list = arg == "--bench-shrink" ? options.benchShrinks : options.benchThreads;
+            if (!ParseIntList(argv[++i], list)) {
+                cerr << arg << " expects a comma-separated list of numbers\n";
+                return 1;
+            }
+        } else if (arg == "--bound-margin" && i + 1 < argc) {
+            options.boundMargin = atoi(argv[++i]);
+        } else if (arg == "--give-up-after" && i + 1 < argc) {
+            options.giveUpAfter = int64_t(atof(argv[++i]));
+        } else if (arg == "--bounds") {
+            options.boundsOnly = true;
+        } else if (arg == "--database" && i + 1 < argc) {
+            options.databasePath = argv[++i];
+        } else if (arg == "--pool-size" && i + 1 < argc) {
+            int poolSize = atoi(argv[++i]);
+            if (poolSize <= 0) {
+                cerr << "--pool-size expects a positive number\n";
+                return 1;
+            }
+            options.poolSize = poolSize;
+        } else if (arg == "--list-database" && i + 1 < argc) {
+            options.listDatabase = argv[++i];
+        } else if (arg == "--board" && i + 1 < argc) {
+            board = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            options.threadCount = atoi(argv[++i]);
+            if (options.threadCount <= 0) {
+                cerr << "--threads expects a positive number\n";
+                return 1;
+            }
+        } else if (arg == "--affinity" && i + 1 < argc) {
+            if (!ParseAffinityPolicy(argv[++i], options.policy)) {
+                cerr << "Unknown affinity policy: " << argv[i] << "\n";
+                return 1;
+            }
+        } else {
+            PrintUsage(argv[0]);
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    if (options.constructive && board != "8x8") {
+        cerr << "The constructive engine only supports the 8x8 board\n";
+        return 1;
+    }
+
+    if (options.boundsOnly) {
+        if (board == "8x8") return PrintIndexBounds<Chess8x8>(options);
+        if (board == "10x8") return PrintIndexBounds<Board10x8>(options);
+        if (board == "10x10") return PrintIndexBounds<Board10x10>(options);
+    }
+    if (!options.listDatabase.empty()) {
+        if (board == "8x8") return ListDatabase<Chess8x8>(options);
+        if (board == "10x8") return ListDatabase<Board10x8>(options);
+        if (board == "10x10") return ListDatabase<Board10x10>(options);
+    }
+
+    CpuTopology topology = DetectTopology();
+    PrintTopology(topology);
+
+    if (options.benchmark) {
+        if (board == "8x8") return RunBenchmark<Chess8x8>(options, topology);
+        if (board == "10x8") return RunBenchmark<Board10x8>(options, topology);
+        if (board == "10x10") return RunBenchmark<Board10x10>(options, topology);
+    }
+    if (board == "8x8") return RunSearch<Chess8x8>(options, topology);
+    if (board == "10x8") return RunSearch<Board10x8>(options, topology);
+    if (board == "10x10") return RunSearch<Board10x10>(options, topology);
+    cerr << "Unknown board geometry: " << board << "\n";
+    return 1;
+}